@@ -0,0 +1,48 @@
+#ifndef _TERMINAL_BLEND__H_
+#define _TERMINAL_BLEND__H_
+
+#include "terminal_color.h"
+#include <cstdint>
+
+// Blending of glyph alpha masks and bitmasks into XRGB_8888 pixels, used by the renderer,
+// and interpolation of rows of XRGB colors, used when blitting consoles
+// The blending uses 8.8 fixed-point weights, see Color::lerpXRGB and Color::alphaToWeight.
+// Vectorized kernels are selected at runtime according to the CPU features,
+// they give the same output as the scalar kernel.
+namespace LRTerminal::Blend
+{
+  // Available kernels
+  enum class Kernel
+  {
+    SCALAR,
+    SSE2,
+    AVX2,
+  };
+
+  // Blend a row of pixels (or a whole glyph, its rows being contiguous)
+  // Each alpha value (0x00 is background, 0xFF is foreground) gives an output pixel in the XRGB_8888 format
+  void blendRow(const uint8_t* const alpha, const unsigned width,
+                const Color& background, const Color& foreground,
+                uint32_t* const out);
+
+  // Select the colors of the rows of a bitmask, see Glyph::getBits
+  // Each set bit gives the foreground and each clear bit the background, as blendRow does with the alpha 0xFF and 0x00.
+  // The rows of the bitmask are (width + 7) / 8 bytes, the output rows are contiguous.
+  void selectRows(const uint8_t* const bits, const unsigned width, const unsigned height,
+                  const Color& background, const Color& foreground,
+                  uint32_t* const out);
+
+  // Interpolate rows of colors: out[i] = Color::lerpXRGB(a[i], b[i], weights[i])
+  // The weights must be in [0; 256]
+  void lerpRow(const uint32_t* const a, const uint32_t* const b, const uint16_t* const weights,
+               const unsigned width, uint32_t* const out);
+
+  // Kernel used by blendRow, selectRows and lerpRow, the best kernel supported by the CPU is used by default
+  Kernel getKernel(void);
+  // Force a kernel, returns false if the CPU does not support it
+  bool setKernel(const Kernel kernel);
+  // Check if the CPU supports a kernel
+  bool isKernelSupported(const Kernel kernel);
+}
+
+#endif
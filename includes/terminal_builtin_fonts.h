@@ -3,53 +3,99 @@
 #define _TERMINAL_BUILTIN_FONTS__H_
 
 #include "terminal_fontdata.h"
+#include "terminal_fontfile.h"
+#include "terminal_glyphatlas.h"
+#include "terminal_terminal.h"
 #include "terminal_textstyle.h"
+#include <array>
 #include <map>
 
 namespace LRTerminal
 {
-  class Glyph;
-
-  // Font sizes
-  const unsigned C_GLYPH_WIDTH(8u);
-  const unsigned C_GLYPH_HEIGHT(16u);
-
-  // The builtin fonts class is a singleton
-  // Outside the loading functions,
+  // The builtin fonts and the custom font of a root console, at the size of its cells
+  // The builtin fonts are built once per cell size and shared by all the instances, they are never modified.
+  // Each RootConsole has its own instance for its custom font, built for the cell size chosen when the game is loaded.
   class BuiltinFonts
   {
   public:
-    // Constructor
-    BuiltinFonts();
+    // Constructor, the glyphs have the size of the cells
+    // The builtin fonts are baked at the cell sizes of the core option, and scaled at the other sizes
+    BuiltinFonts(const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
     // Destructor
     ~BuiltinFonts();
     //
     const FontData& getFontData(const Font font) const;
-    const Glyph& getGlyph(const Font font, const char32_t codePoint) const;
-
-    // Load an XBM image as part of a font, used for initializing the builtin fonts data
-    void loadXbmFont(const Font font, const char32_t startingCodePoint,
-                     const unsigned width, const unsigned height,
-                     const unsigned char* const xbmImage);
+    // Glyph of a code point in a font, or in the default font if the font does not have it
+    Glyph getGlyph(const Font font, const char32_t codePoint) const;
+    // Storage of the glyphs of the builtin fonts, shared by the instances of the same cell size
+    const GlyphAtlas& getAtlas(void) const;
+    // Storage of the glyphs of the custom font
+    const GlyphAtlas& getCustomAtlas(void) const;
 
     // TODO: Load an XPM image
 
     // Add glyphs to the custom font. The custom font has initially no glyphs
     // The image in parameter represents the alpha mask of the glyphs
     // Each char corresponds to the opacity level of a pixel, 0x00 is transparent, 0xFF is opaque
+    // The image is a sheet of glyphs of glyphWidth x glyphHeight, they are centered in the cells, and cropped if too large
     void addToCustomFont(const char32_t startingCodePoint,
                          const unsigned width, const unsigned height,
-                         const unsigned char* const image);
+                         const unsigned char* const image,
+                         const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
     // Add glyphs to he custom font. The glyphs are formatted in a monochrome XBM image
+    // The builtin fonts are not loaded with it, they are decoded at build time, see tools/bake_fonts.cpp
     void addXBMToCustomFont(const char32_t startingCodePoint,
                             const unsigned width, const unsigned height,
-                            const unsigned char* const image);
+                            const unsigned char* const image,
+                            const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
+    // Add the glyphs of a font file to the custom font, they are resized if they are not of the size of the cells
+    void addToCustomFont(const FontFile::BitmapFont& font);
 
   private:
-    // Map Font <-> FontData
-    std::map<Font, FontData> m_fonts;
+    // Number of fonts
+    static const unsigned C_FONT_COUNT = static_cast<unsigned>(Font::CUSTOM) + 1u;
+    // Builtin fonts of a cell size, see terminal_builtin_fonts.cpp
+    struct SharedFonts;
+    // Builtin fonts of a cell size, built by the first call for this size
+    static const SharedFonts& _getSharedFonts(const unsigned glyphWidth, const unsigned glyphHeight);
+    // Glyph of the custom font, or of the default font if the custom font does not have it
+    Glyph _getCustomGlyph(const char32_t codePoint) const;
+    // Add the glyphs of an alpha sheet of glyphs of glyphWidth x glyphHeight to the custom font
+    // The glyphs are moved to a sheet of the size of the cells first if they are not of this size
+    void _addGlyphSheet(const char32_t startingCodePoint,
+                        const unsigned width, const unsigned height, const uint8_t* const image,
+                        const unsigned glyphWidth, const unsigned glyphHeight);
+
+    // Builtin fonts, shared by the instances of the same cell size
+    const SharedFonts& m_sharedFonts;
+    // Fonts indexed by Font, for the glyph lookups, the custom font is looked up by _getCustomGlyph
+    std::array<const FontData*, C_FONT_COUNT> m_fontTable;
+    // Images of the glyphs of the custom font
+    GlyphAtlas m_customAtlas;
+    // The custom font has no fallback font, its missing glyphs are taken in the default font by _getCustomGlyph
+    // as the glyphs of the two fonts are in different atlases
+    FontData m_customFont;
   };
 
+  ////
+  // Inline implementations
+  inline Glyph BuiltinFonts::getGlyph(const Font font, const char32_t codePoint) const
+  {
+    if (font == Font::CUSTOM)
+    {
+      return _getCustomGlyph(codePoint);
+    }
+    const unsigned index = static_cast<unsigned>(font);
+    const FontData& fontData = (index < C_FONT_COUNT) ? *m_fontTable[index] : *m_fontTable[0];
+    return fontData.findGlyph(codePoint);
+  }
+
+  inline Glyph BuiltinFonts::_getCustomGlyph(const char32_t codePoint) const
+  {
+    return m_customFont.hasGlyph(codePoint) ? m_customFont.findGlyph(codePoint)
+                                            : m_fontTable[0]->findGlyph(codePoint);
+  }
+
 }
 
 #endif
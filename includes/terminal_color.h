@@ -48,7 +48,9 @@ namespace LRTerminal
     void getHSL(float& H, float& S, float& L);
 
     // Convert to an XRGB value
-    unsigned toXRGB(void) const;
+    uint32_t toXRGB(void) const;
+    // Convert from an XRGB value
+    static Color fromXRGB(const uint32_t xrgb);
 
     // Setters
     void setRed(uint8_t R);
@@ -70,8 +72,18 @@ namespace LRTerminal
 
     //
     // Interpolation/Extrapolation
+    // Note: the coefficient is converted to a 8.8 fixed-point weight, see lerpFixed
     static Color lerp(const Color& a, const Color& b, const float coeff);
 
+    // Fixed-point interpolation, the weight is in 8.8 fixed-point: 0 gives a, 256 gives b
+    static Color lerpFixed(const Color& a, const Color& b, const unsigned weight);
+    // Fixed-point interpolation of XRGB values, used when blending many pixels or cells
+    static uint32_t lerpXRGB(const uint32_t a, const uint32_t b, const unsigned weight);
+    // Convert an interpolation coefficient into a 8.8 fixed-point weight, clamped to [0;256]
+    static unsigned toWeight(const float coeff);
+    // Convert an alpha level (0x00 is transparent, 0xFF is opaque) into a 8.8 fixed-point weight
+    static unsigned alphaToWeight(const uint8_t alpha);
+
     // Other operations
     // Lighten: max on each component
     static Color lighten(const Color& a, const Color& b);
@@ -0,0 +1,131 @@
+#ifndef _TERMINAL_COMPOSITOR__H_
+#define _TERMINAL_COMPOSITOR__H_
+
+#include "terminal_console.h"
+#include "terminal_dirtytracker.h"
+#include <vector>
+
+namespace LRTerminal
+{
+  // Stack of consoles (layers) composited onto another console, usually the root console
+  // The result is the same as clearing the target with its default style and blitting the layers
+  // from bottom to top, except that an opaque cell always keeps its own font (blitting keeps the font
+  // of the destination if it already displays the same character).
+  // Only the cells whose layers have changed since the last composition are composited,
+  // and the layers under an opaque cell are skipped.
+  class Compositor
+  {
+  public:
+    // A layer is a console with a position and alpha levels for blitting
+    // The ignore cell color of the console is used too
+    class Layer: public Console
+    {
+    public:
+      Layer(const unsigned width, const unsigned height, const int x, const int y);
+      virtual ~Layer();
+
+      // Position of the layer in the target console
+      void setPosition(const int x, const int y);
+      int getX(void) const;
+      int getY(void) const;
+      // Alpha levels, see Console::blit
+      void setAlpha(const float foregroundAlpha, const float backgroundAlpha);
+      float getForegroundAlpha(void) const;
+      float getBackgroundAlpha(void) const;
+      // Hidden layers are not composited
+      void setVisible(const bool isVisible);
+      bool isVisible(void) const;
+
+    protected:
+      // The moved cells have to be composited again
+      virtual void _onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                             const int dx, const int dy);
+
+    private:
+      friend class Compositor;
+
+      // State of the layer when it was last composited
+      struct ComposedState
+      {
+        int x;
+        int y;
+        float foregroundAlpha;
+        float backgroundAlpha;
+        bool isVisible;
+        bool isIgnoreCellColorEnabled;
+        uint32_t ignoreCellColor; // XRGB
+        bool operator==(const ComposedState& that) const;
+      };
+      ComposedState _getState(void) const;
+      // Call onChanged(x, y) for the dirty cells whose content differs from when they were last composited,
+      // and remember their new content. Clearing and redrawing a layer at each frame marks all its cells
+      // dirty, while most of them are unchanged.
+      template <typename Function>
+      void _collectChangedCells(Function onChanged);
+      // Check if a cell of the layer hides the layers below it
+      bool _isOpaqueAt(const int x, const int y) const;
+
+      int m_x;
+      int m_y;
+      float m_foregroundAlpha;
+      float m_backgroundAlpha;
+      bool m_isVisible;
+      bool m_isComposed; // The layer has been composited at least once
+      ComposedState m_composedState;
+      // Content of a cell when it was last composited
+      struct ComposedCell
+      {
+        char32_t codePoint;
+        uint32_t foreground; // XRGB
+        uint32_t background; // XRGB
+        uint8_t font;
+      };
+      std::vector<ComposedCell> m_composedCells; // size = width * height
+    };
+
+    // Constructor, destructor
+    // The size should be the size of the target console
+    Compositor(const unsigned width, const unsigned height);
+    ~Compositor();
+
+    // Add a layer on top of the others, the layer is owned by the compositor
+    Layer& addLayer(const unsigned width, const unsigned height, const int x, const int y);
+    // Remove and destroy a layer
+    void removeLayer(Layer& layer);
+    // Change the position of a layer in the stack, 0 is the bottom
+    void setLayerIndex(Layer& layer, const unsigned index);
+    // Layers, from bottom to top
+    unsigned getLayerCount(void) const;
+    Layer& getLayer(const unsigned index);
+
+    // Composite the changed cells into the target console
+    void compose(Console& target);
+    // Composite all the cells at the next call to compose, for example if the target has been modified
+    void invalidate(void);
+
+  private:
+    // Copy constructor & operator = are declared but not implemented
+    Compositor(const Compositor& that);
+    Compositor& operator=(const Compositor& that);
+
+    // Index of a layer in the stack
+    unsigned _findLayer(const Layer& layer) const;
+    // Mark the cells covered by a layer in a given state
+    void _damageArea(const Layer& layer, const Layer::ComposedState& state);
+    // Gather the changes of the layers
+    void _collectDamage(void);
+    // Index of the lowest layer that has to be blitted for a cell
+    unsigned _findFirstVisibleLayer(const int x, const int y) const;
+    // Composite the cells [x; x + count[ of a row, starting at a layer
+    void _composeRun(Console& target, const TextStyle& baseStyle,
+                     const int x, const int y, const unsigned count, const unsigned firstLayer);
+
+    unsigned m_width;
+    unsigned m_height;
+    std::vector<Layer*> m_layers; // From bottom to top
+    DirtyTracker m_damage; // Cells of the target that have to be composited
+  };
+
+}
+
+#endif
@@ -4,20 +4,32 @@
 
 #include "terminal_color.h"
 #include "terminal_textstyle.h"
+#include "terminal_dirtytracker.h"
+#include "terminal_textlayout.h"
 #include <string>
+#include <string_view>
 #include <cstdarg>
+#include <cstdint>
+#include <vector>
+#include <memory>
 
 namespace LRTerminal
 {
   // Note: The console class is somewhat based on the libtcod interface, but they are some differences
   // This class represents an offscreen console that can be blitted on other offscreen consoles
   // or the root console.
+  // Copying a console is cheap: the cells are stored in chunks of rows shared by the copies,
+  // and a chunk is only duplicated when one of the consoles first writes into it.
   class Console
   {
   public:
     // Constructor, destructor
     Console(const unsigned width, const unsigned height);
     virtual ~Console();
+    // Copies share the cells and the clear state, the caches of the copy start empty
+    // All the cells of the copy are marked as modified, like for a new console.
+    Console(const Console& that);
+    Console& operator=(const Console& that);
 
     // Set default styles
     void setDefaultStyle(const TextStyle& style);
@@ -48,47 +60,59 @@ namespace LRTerminal
     // Set the font variant of a cell
     void setFont(const int x, const int y, const Font font);
 
+    // Note: the functions taking strings take views, so they can be called with std::string, std::u32string,
+    // string literals or parts of buffers without building a temporary string.
+    // The formatted strings are built in a stack buffer when they are short enough.
+    // The views are not available to SWIG, which uses the formatted strings.
+
     // Print a formatted string with default style
     void print(const int x, const int y, const char* fmt, ...);
-    // Print an utf-8 string with default style
-    void print(const int x, const int y, const std::string& str);
-    // Print an utf-32 string with default style
-    void print(const int x, const int y, const std::u32string& str);
     // Print a formatted string, with specific style
     void print(const int x, const int y, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    // Print an utf-8 string with default style
+    void print(const int x, const int y, const std::string_view str);
+    // Print an utf-32 string with default style
+    void print(const int x, const int y, const std::u32string_view str);
     // Print an utf-8 string, with specific style
-    void print(const int x, const int y, const TextStyle& style, const std::string& str);
+    void print(const int x, const int y, const TextStyle& style, const std::string_view str);
     // Print an utf-32 string, with specific style
-    void print(const int x, const int y, const TextStyle& style, const std::u32string& str);
+    void print(const int x, const int y, const TextStyle& style, const std::u32string_view str);
+#endif
 
     // Print a string with autowrap inside a rectangle
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
                    const bool clearText, const char* fmt, ...);
-    // Print an utf-8 string with autowrap inside a rectangle and default style
+    // Print a string with autowrap inside a rectangle and specific style
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
-                   const bool clearText, const std::string& str);
-    // Print an utf-32 string with autowrap inside a rectangle and default style
+                   const bool clearText, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    // Print an utf-8 string with autowrap inside a rectangle and default style
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
-                   const bool clearText, const std::u32string& str);
-    // Print a string with autowrap inside a rectangle and specific style
+                   const bool clearText, const std::string_view str);
+    // Print an utf-32 string with autowrap inside a rectangle and default style
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
-                   const bool clearText, const TextStyle& style, const char* fmt, ...);
+                   const bool clearText, const std::u32string_view str);
     // Print an utf-8 string with autowrap inside a rectangle and specific style
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
-                   const bool clearText, const TextStyle& style, const std::string& str);
+                   const bool clearText, const TextStyle& style, const std::string_view str);
     // Print an utf-32 string with autowrap inside a rectangle and specific style
     void printRect(const int x, const int y,
                    const unsigned w, const unsigned h,
-                   const bool clearText, const TextStyle& style, const std::u32string& str);
+                   const bool clearText, const TextStyle& style, const std::u32string_view str);
+#endif
     // Get the number of lines for an autowrapped text
+    // The lines are cached, so printing the same text in the same width afterwards does not wrap it again
     unsigned getHeightRect(const unsigned w, const char* fmt, ...);
-    unsigned getHeightRect(const unsigned w, const std::string& str);
-    unsigned getHeightRect(const unsigned w, const std::u32string& str);
+#ifndef SWIG
+    unsigned getHeightRect(const unsigned w, const std::string_view str);
+    unsigned getHeightRect(const unsigned w, const std::u32string_view str);
+#endif
 
     // TODO: style control ?
 
@@ -110,22 +134,38 @@ namespace LRTerminal
                     const bool clearText);
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
                     const bool clearText, const char* fmt, ...);
+#ifndef SWIG
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
-                    const bool clearText, const std::string& title);
+                    const bool clearText, const std::string_view title);
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
-                    const bool clearText, const std::u32string& title);
+                    const bool clearText, const std::u32string_view title);
+#endif
     // Specific style
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
                     const bool clearText, const TextStyle& style);
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
                     const bool clearText, const TextStyle& style,
                     const char* fmt, ...);
+#ifndef SWIG
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
                     const bool clearText, const TextStyle& style,
-                    const std::string& title);
+                    const std::string_view title);
     void printFrame(const int x, const int y, const unsigned w, const unsigned h,
                     const bool clearText, const TextStyle& style,
-                    const std::u32string& title);
+                    const std::u32string_view title);
+#endif
+
+    // Scroll the content of a rectangle by (dx, dy) cells
+    // The content moved outside the rectangle is lost, and the uncovered cells are cleared with the default style
+    void scroll(const int x, const int y, const unsigned w, const unsigned h, const int dx, const int dy);
+
+    // Snapshots
+    // Copy of the console sharing its cells, see the copy constructor
+    Console snapshot(void) const;
+    // Set the cells to the ones of a snapshot of the same size, and share them with it
+    // Only the rows that differ from the snapshot are marked as modified.
+    // The default style and the ignore cell color are kept.
+    void restore(const Console& snapshot);
 
     // Getters
     // Width of console
@@ -152,9 +192,9 @@ namespace LRTerminal
     // Note: values from the default style are used when they aren't present at cell level
     TextStyle getStyle(const int x, const int y) const;
     // Background of a cell
-    const Color& getBackground(const int x, const int y) const;
+    Color getBackground(const int x, const int y) const;
     // Foreground of a cell
-    const Color& getForeground(const int x, const int y) const;
+    Color getForeground(const int x, const int y) const;
     // Font of a cell
     Font getFont(const int x, const int y) const;
 
@@ -167,57 +207,141 @@ namespace LRTerminal
     void setIgnoreCellColor(const Color& col);
     // Reset (disable) the ignore cell color
     void resetIgnoreCellColor();
+    // Ignore cell color, only used if enabled
+    bool isIgnoreCellColorEnabled(void) const;
+    const Color& getIgnoreCellColor(void) const;
 
   protected:
+    // Packed content of a row of cells, colors are stored as XRGB
+    struct CellSpan
+    {
+      const char32_t* codePoints;
+      const uint32_t* foregrounds;
+      const uint32_t* backgrounds;
+      const uint8_t* fonts;
+    };
+
+    // A cell is blank if its code point is Nul or Space
+    static bool _isBlank(const char32_t codePoint);
     // For use when rendering the console
     bool _isDirty(const int x, const int y) const;
     void _unsetDirty(const int x, const int y);
+    // Content of a row, valid until the console is modified
+    // Reading does not modify the console, so different rows can be read from different threads.
+    CellSpan _getRowCells(const unsigned y) const;
+    // Cells modified since the last rendering
+    DirtyTracker& _getDirtyCells(void);
+    // Called when the content of the rectangle [x0; x1[ x [y0; y1[ is moved by (dx, dy),
+    // before the uncovered cells are cleared. The move is smaller than the rectangle.
+    virtual void _onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                           const int dx, const int dy);
 
   private:
-    // Class representing a cell of the console
-    class ConsoleCell
+    friend class ConsoleView;
+    friend class DrawList;
+
+    // Origin and clipping rectangle applied to the coordinates when drawing, see ConsoleView
+    // The clipping rectangle [xMin; xMax[ x [yMin; yMax[ is in console coordinates
+    struct Viewport
+    {
+      int x;
+      int y;
+      int xMin;
+      int yMin;
+      int xMax;
+      int yMax;
+    };
+
+    // Apply a background flag to the current background of a cell
+    static Color _blendBackground(const Color& current, const Color& color, const BackgroundFlag flag);
+    // Background of a cell after applying a color with a background flag, as XRGB
+    static uint32_t _computeBackground(const uint32_t current, const Color& color, const BackgroundFlag flag);
+    // Set all the properties of a cell, which is marked dirty if it has changed
+    // The row of the cell must be resolved
+    void _setCell(const unsigned x, const unsigned y, const char32_t codePoint,
+                  const uint32_t foreground, const uint32_t background, const uint8_t font);
+    // Set all the properties of a run of cells of a row, starting at (x, y) in drawing coordinates
+    void _setCells(const int x, const int y, const unsigned count, const CellSpan& cells);
+
+    // Cells of a chunk of rows, each property in its own array
+    // The cell (x, y) of the chunk is at index y * width + x
+    struct CellChunk
+    {
+      std::vector<char32_t> codePoints; // Code point of the character of each cell
+      std::vector<uint32_t> foregrounds; // Foreground color of each cell, as XRGB
+      std::vector<uint32_t> backgrounds; // Background color of each cell, as XRGB
+      std::vector<uint8_t> fonts; // Font in which the character of each cell should be rendered
+    };
+    // Chunk containing a row, and index of the first cell of the row in the chunk
+    const CellChunk& _getChunk(const unsigned y) const;
+    unsigned _getRowIndex(const unsigned y) const;
+    // Check if a row has the same content as the row of another console
+    bool _isSameRow(const Console& that, const unsigned y) const;
+
+    // Blitting of a row of cells
+    struct BlitWeights
     {
-    public:
-      ConsoleCell();
-      const Color& getBackground(void) const;
-      const Color& getForeground(void) const;
-      char32_t getCodePoint(void) const;
-      Font getFont(void) const;
-      bool isDirty(void) const;
-      bool isBlank(void) const;
-
-      void setForeground(const Color& color);
-      void setBackground(const Color& color, const BackgroundFlag flag = BackgroundFlag::SET);
-      void setCodePoint(const char32_t codePoint);
-      void setFont(const Font font);
-
-      void unsetDirty(void);
-
-    private:
-      Color m_background; // Background color of the cell
-      Color m_foreground; // Foreground color of the cell
-      char32_t m_codePoint; // Codepoint of the character of the cell
-      Font m_font; // Font in which the character should be rendered
-      bool m_isDirty; // Flag to tell if the cell should be redrawn
+      uint16_t background;
+      uint16_t foreground;
+      uint16_t foregroundLow; // Used when the foreground alpha is lower than 0.5
+      uint16_t foregroundHigh; // Used when the foreground alpha is at least 0.5
+      bool isForegroundLow;
     };
+    void _blitRowOpaque(const CellSpan& src, const bool isIgnoreCellColorEnabled, const uint32_t ignoreCellColor,
+                        const unsigned x, const unsigned y, const unsigned count);
+    void _blitRowAlpha(const CellSpan& src, const bool isIgnoreCellColorEnabled, const uint32_t ignoreCellColor,
+                       const BlitWeights& weights, const unsigned x, const unsigned y, const unsigned count);
+
+    // Clearing is lazy: a row is cleared if it has not been written since the last clear
+    bool _isRowCleared(const unsigned y) const;
+    // Prepare a row for writing into it: the chunk of the row is duplicated if it is shared,
+    // and the pending clear is applied. Returns the chunk of the row.
+    CellChunk& _resolveRow(const unsigned y);
+    // Content of a cell, taking into account a pending clear of its row
+    char32_t _getCodePointAt(const unsigned x, const unsigned y) const;
+    uint32_t _getForegroundAt(const unsigned x, const unsigned y) const;
+    uint32_t _getBackgroundAt(const unsigned x, const unsigned y) const;
+    uint8_t _getFontAt(const unsigned x, const unsigned y) const;
 
     bool _isInside(const int x, const int y) const;
-    int _cellIndex(const int x, const int y) const;
-    // Get the expected size of a formatted string
-    static int _computeStringSize(const char* fmt, va_list args);
-    // Compute a formatted string
-    static std::string _computeString(int stringSize, const char* fmt, va_list args);
-    // Convert a utf8 string into a utf-32 string, suitable for filling the console
-    static std::u32string _stringToU32String(const std::string str);
-    // Split a string into lines according to a given width
-    static std::vector<std::u32string> _splitRect(const unsigned w, const std::u32string& str);
-
-    std::vector<ConsoleCell> m_cells; // Cells of the console, size = width * height
+    // Index of a cell in the chunk of its row
+    unsigned _cellIndex(const int x, const int y) const;
+    // Translate drawing coordinates through the viewport, false if the cell is clipped
+    bool _mapCell(const int x, const int y, int& xCell, int& yCell) const;
+    // Size of the stack buffers for formatted strings
+    static const unsigned C_FORMAT_BUFFER_SIZE = 256u;
+    // Format a string into a buffer of C_FORMAT_BUFFER_SIZE chars,
+    // or into a buffer of the console (valid until the next call) if the string is longer
+    std::string_view _formatText(char* const buffer, const char* fmt, va_list args);
+    // Same, the longer strings are formatted into fallback
+    static std::string_view _formatText(char* const buffer, std::string& fallback, const char* fmt, va_list args);
+    // Decode a utf-8 string into a buffer of the console, valid until the next call
+    const std::u32string& _decodeText(const std::string_view str);
+    // Position of the first character of a printed string, according to the alignment
+    static int _computeStartPosition(const int x, const unsigned length, const Alignment align);
+
+    // Cells of the console, in chunks of rows shared with the copies of the console
+    std::vector<std::shared_ptr<CellChunk>> m_chunks;
     unsigned m_width; // Width of the console
     unsigned m_height; // Height of the console
     TextStyle m_defaultStyle; // Default text style
     bool m_isIgnoreCellColorEnabled; // By default, ignored cells feature is disabled when blitting
     Color m_ignoreCellColor; // Background color for indicating ignored cells when blitting
+    DirtyTracker m_dirtyCells; // Cells that should be redrawn
+    Viewport m_viewport; // The whole console, except while a view is drawing
+    std::u32string m_decodedText; // Buffer for decoding utf-8 strings
+    std::string m_formattedText; // Buffer for the formatted strings too long for the stack buffers
+    TextLayoutCache m_textLayouts; // Wrapped lines of the last texts printed in rectangles
+    // Buffers for blitting rows
+    std::vector<uint32_t> m_blitColors;
+    std::vector<uint16_t> m_blitWeights;
+    // Lazy clear
+    uint64_t m_clearGeneration; // Incremented at each clear
+    std::vector<uint64_t> m_rowGenerations; // Clear generation of the content of each row
+    uint32_t m_clearForeground; // Cells values of the last clear
+    uint32_t m_clearBackground;
+    uint8_t m_clearFont;
+    std::shared_ptr<CellChunk> m_clearedRow; // A row of cleared cells, for reading the cleared rows, shared with the copies
   };
 
 }
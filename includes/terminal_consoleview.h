@@ -0,0 +1,123 @@
+#ifndef _TERMINAL_CONSOLEVIEW__H_
+#define _TERMINAL_CONSOLEVIEW__H_
+
+#include "terminal_console.h"
+
+namespace LRTerminal
+{
+  // Rectangular part of a console that can be drawn into like a console
+  // The coordinates are relative to the view, and everything drawn outside of the view is clipped.
+  // The cells are directly written into the console, and the default style of the console is used.
+  // The view does not own anything: the console must outlive it.
+  class ConsoleView
+  {
+  public:
+    // Constructors
+    // View of the rectangle (x, y, w, h) of a console
+    ConsoleView(Console& console, const int x, const int y, const unsigned w, const unsigned h);
+    // View of the rectangle (x, y, w, h) of another view, also clipped by that view
+    ConsoleView(const ConsoleView& parent, const int x, const int y, const unsigned w, const unsigned h);
+
+    // Console containing the view
+    Console& getConsole(void) const;
+    // Size of the view
+    unsigned getWidth(void) const;
+    unsigned getHeight(void) const;
+
+    // Fill the view with the default style of the console
+    void clear(void);
+
+    // Cells, see Console
+    void setChar(const int x, const int y, const char32_t c);
+    void setChar(const int x, const int y, const char32_t c, const TextStyle& style);
+    void setStyle(const int x, const int y, const TextStyle& style);
+    void setBackground(const int x, const int y, const Color& col,
+                       const BackgroundFlag flag = BackgroundFlag::SET);
+    void setForeground(const int x, const int y, const Color& col);
+    void setFont(const int x, const int y, const Font font);
+
+    // Printing, see Console
+    void print(const int x, const int y, const char* fmt, ...);
+#ifndef SWIG
+    void print(const int x, const int y, const std::string_view str);
+    void print(const int x, const int y, const std::u32string_view str);
+#endif
+    void print(const int x, const int y, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    void print(const int x, const int y, const TextStyle& style, const std::string_view str);
+    void print(const int x, const int y, const TextStyle& style, const std::u32string_view str);
+#endif
+
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const char* fmt, ...);
+#ifndef SWIG
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const std::string_view str);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const std::u32string_view str);
+#endif
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const std::string_view str);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const std::u32string_view str);
+#endif
+
+    // Shapes, see Console
+    void rect(const int x, const int y, const unsigned w, const unsigned h,
+              const bool clearText);
+    void rect(const int x, const int y, const unsigned w, const unsigned h,
+              const bool clearText, const TextStyle& style);
+    void hline(const int x, const int y, const unsigned l);
+    void hline(const int x, const int y, const unsigned l, const TextStyle& style);
+    void vline(const int x, const int y, const unsigned l);
+    void vline(const int x, const int y, const unsigned l, const TextStyle& style);
+
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const char* fmt, ...);
+#ifndef SWIG
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const std::string_view title);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const std::u32string_view title);
+#endif
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const char* fmt, ...);
+#ifndef SWIG
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const std::string_view title);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const std::u32string_view title);
+#endif
+
+  private:
+    // Set the viewport of the console to the view for the lifetime of the object
+    class Scope
+    {
+    public:
+      Scope(const ConsoleView& view);
+      ~Scope();
+
+    private:
+      Console& m_console;
+      Console::Viewport m_previous;
+    };
+
+    Console& m_console;
+    unsigned m_width;
+    unsigned m_height;
+    Console::Viewport m_viewport; // In the console coordinates, the clipping rectangle is inside the console
+  };
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef _TERMINAL_DIRTYTRACKER__H_
+#define _TERMINAL_DIRTYTRACKER__H_
+
+#include <cstdint>
+#include <vector>
+
+namespace LRTerminal
+{
+  // Set of the cells of a console that have changed since the last rendering
+  // Each row is a bitset of cells, and a summary bitset tells which rows contain dirty cells,
+  // so the dirty cells are enumerated without visiting the clean rows.
+  class DirtyTracker
+  {
+  public:
+    // Constructor, all the cells are initially dirty
+    DirtyTracker(const unsigned width, const unsigned height);
+
+    // Mark a cell as dirty, the cell must be inside the console
+    void mark(const unsigned x, const unsigned y);
+    // Mark all the cells as dirty
+    void markAll(void);
+    // Mark a cell as clean
+    void unmark(const unsigned x, const unsigned y);
+    // Move the dirty cells of the rectangle [x0; x1[ x [y0; y1[ by (dx, dy), like Utils::moveRect
+    // The cells uncovered by the move are marked dirty
+    void moveRect(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                  const int dx, const int dy);
+    // Check if a cell is dirty
+    bool isDirty(const unsigned x, const unsigned y) const;
+    // Check if no cell is dirty
+    bool isEmpty(void) const;
+
+    // First row at or after a given row containing dirty cells, or the height if there is none
+    unsigned nextDirtyRow(const unsigned row) const;
+    // Call function(x, y) for each dirty cell of the rows [firstRow; lastRow[
+    template <typename Function>
+    void forEachDirtyCell(const unsigned firstRow, const unsigned lastRow, Function function) const;
+
+    // Clear the cells of the rows [firstRow; lastRow[
+    // Each row has its own words, so disjoint ranges of rows can be cleared from different threads.
+    // The row summary is not modified: it must be cleared with clearRowSummary once all the rows are clean.
+    void clearRows(const unsigned firstRow, const unsigned lastRow);
+    // Clear the summary of the dirty rows
+    void clearRowSummary(void);
+
+  private:
+    static unsigned _countTrailingZeros(const uint64_t word);
+
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_wordsPerRow; // Number of 64 bits words for the cells of a row
+    std::vector<uint64_t> m_cells; // Dirty cells, size = wordsPerRow * height
+    std::vector<uint64_t> m_rows; // Rows containing dirty cells, one bit per row
+    std::vector<uint64_t> m_movedCells; // Buffer for moveRect, cells as (y << 32) | x
+  };
+
+  ////
+  // Inline implementations
+  inline void DirtyTracker::mark(const unsigned x, const unsigned y)
+  {
+    m_cells[(y * m_wordsPerRow) + (x >> 6)] |= UINT64_C(1) << (x & 63u);
+    m_rows[y >> 6] |= UINT64_C(1) << (y & 63u);
+  }
+
+  inline unsigned DirtyTracker::_countTrailingZeros(const uint64_t word)
+  {
+#ifdef __GNUC__
+    return __builtin_ctzll(word);
+#else
+    unsigned ret = 0u;
+    while (((word >> ret) & 1u) == 0u)
+    {
+      ++ret;
+    }
+    return ret;
+#endif
+  }
+
+  template <typename Function>
+  void DirtyTracker::forEachDirtyCell(const unsigned firstRow, const unsigned lastRow, Function function) const
+  {
+    for (unsigned row = nextDirtyRow(firstRow); row < lastRow; row = nextDirtyRow(row + 1u))
+    {
+      const uint64_t* const words = &m_cells[row * m_wordsPerRow];
+      for (unsigned w = 0u; w < m_wordsPerRow; ++w)
+      {
+        uint64_t bits = words[w];
+        while (bits != 0u)
+        {
+          function((w << 6) + _countTrailingZeros(bits), row);
+          // Remove the lowest bit
+          bits &= bits - 1u;
+        }
+      }
+    }
+  }
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef _TERMINAL_DRAWLIST__H_
+#define _TERMINAL_DRAWLIST__H_
+
+#include "terminal_console.h"
+#include "terminal_dirtytracker.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LRTerminal
+{
+  // Recorded list of console drawing operations, for the parts of the screen that do not change
+  // The operations are recorded once, with their strings already decoded, and drawn at each frame
+  // onto any console and at any offset by a single loop over the recorded commands.
+  // The operations without a style use the default style of the console they are drawn onto.
+  // A list can also be flattened: the cells it produces are computed once and drawn as spans of cells.
+  class DrawList
+  {
+  public:
+    // Constructor
+    DrawList();
+
+    // Remove all the operations
+    void clear(void);
+    // Number of recorded operations
+    unsigned getCommandCount(void) const;
+
+    // Recording, see Console
+    void setChar(const int x, const int y, const char32_t c, const TextStyle& style);
+
+    void print(const int x, const int y, const char* fmt, ...);
+    void print(const int x, const int y, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    void print(const int x, const int y, const std::string_view str);
+    void print(const int x, const int y, const std::u32string_view str);
+    void print(const int x, const int y, const TextStyle& style, const std::string_view str);
+    void print(const int x, const int y, const TextStyle& style, const std::u32string_view str);
+#endif
+
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const char* fmt, ...);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const char* fmt, ...);
+#ifndef SWIG
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const std::string_view str);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const std::u32string_view str);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const std::string_view str);
+    void printRect(const int x, const int y, const unsigned w, const unsigned h,
+                   const bool clearText, const TextStyle& style, const std::u32string_view str);
+#endif
+
+    void rect(const int x, const int y, const unsigned w, const unsigned h,
+              const bool clearText);
+    void rect(const int x, const int y, const unsigned w, const unsigned h,
+              const bool clearText, const TextStyle& style);
+    void hline(const int x, const int y, const unsigned l);
+    void hline(const int x, const int y, const unsigned l, const TextStyle& style);
+    void vline(const int x, const int y, const unsigned l);
+    void vline(const int x, const int y, const unsigned l, const TextStyle& style);
+
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const char* fmt, ...);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const char* fmt, ...);
+#ifndef SWIG
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const std::string_view title);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const std::u32string_view title);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const std::string_view title);
+    void printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                    const bool clearText, const TextStyle& style,
+                    const std::u32string_view title);
+#endif
+
+    // Draw the operations onto a console, with their coordinates moved by (x, y)
+    void draw(Console& console, const int x = 0, const int y = 0) const;
+
+    // Flattening
+    // Compute the cells produced by the operations in the rectangle (0, 0, width, height),
+    // the operations are then drawn as spans of cells. The cells outside the rectangle are dropped.
+    // The cells are computed on a console cleared with the given style, which is also used for the
+    // operations without a style: the result is the same as drawing the operations if the console
+    // is in that state, or if the operations fully overwrite their cells (text cleared, SET background).
+    // Recording another operation or clearing the list removes the flattened cells.
+    void flatten(const unsigned width, const unsigned height, const TextStyle& defaultStyle);
+    bool isFlattened(void) const;
+
+  private:
+    // Recorded operation
+    enum class CommandType : uint8_t
+    {
+      SET_CHAR,
+      PRINT,
+      PRINT_RECT,
+      RECT,
+      HLINE,
+      VLINE,
+      PRINT_FRAME
+    };
+    struct Command
+    {
+      CommandType type;
+      bool clearText;
+      uint32_t style; // Index in the recorded styles, or C_DEFAULT_STYLE
+      int32_t x;
+      int32_t y;
+      uint32_t w; // Length for the lines
+      uint32_t h;
+      uint32_t textOffset; // Text in the recorded code points, or the character of SET_CHAR
+      uint32_t textLength;
+    };
+    // Style of the operations without a style
+    static const uint32_t C_DEFAULT_STYLE = ~0u;
+
+    // A run of flattened cells of a row
+    struct Span
+    {
+      int32_t x;
+      int32_t y;
+      uint32_t count;
+      uint32_t firstCell; // Index of the first cell in the flattened cells
+    };
+
+    // Add a command, whose text is in the recorded code points
+    void _record(const CommandType type, const int x, const int y, const unsigned w, const unsigned h,
+                 const bool clearText, const uint32_t style, const uint32_t textOffset, const uint32_t textLength);
+    // Add a string to the recorded code points, returns its offset
+    uint32_t _addText(const std::u32string_view str);
+    uint32_t _addText(const std::string_view str);
+    uint32_t _addText(const char* fmt, va_list args);
+    uint32_t _addStyle(const TextStyle& style);
+    // Draw a command with its coordinates moved by (x, y)
+    void _drawCommand(const Command& command, Console& console, const int x, const int y) const;
+    // Mark the cells written by a command
+    void _markCells(const Command& command, const TextStyle& defaultStyle, DirtyTracker& cells,
+                    const unsigned width, const unsigned height) const;
+
+    std::vector<Command> m_commands;
+    std::vector<TextStyle> m_styles;
+    std::u32string m_text; // Code points of the recorded strings
+    // Flattened cells
+    bool m_isFlattened;
+    std::vector<Span> m_spans;
+    std::vector<char32_t> m_codePoints;
+    std::vector<uint32_t> m_foregrounds;
+    std::vector<uint32_t> m_backgrounds;
+    std::vector<uint8_t> m_fonts;
+  };
+
+}
+
+#endif
@@ -1,18 +1,25 @@
-
 #ifndef _TERMINAL_FONTDATA__H_
 #define _TERMINAL_FONTDATA__H_
 
 #include "terminal_glyphs.h"
-#include <map>
+#include "terminal_glyphatlas.h"
+#include <array>
+#include <vector>
 
 namespace LRTerminal
 {
-  // A font is a map of glyphs
+  // A font is a table of glyphs indexed by code point
+  // The images of the glyphs are stored in an atlas, which can be shared by several fonts.
+  // The table has two levels: the block of 256 code points of a code point gives a page of glyphs,
+  // and the blocks without any glyph share an empty page, so a lookup is two array loads.
+  // A font can fall back on another font for the glyphs it does not have. The fallback is resolved
+  // in a second table by resolve(), so findGlyph does not search the fonts one after another.
   class FontData
   {
   public:
     // Constructor & destructor
-    FontData(unsigned glyphWidth, unsigned glyphHeight);
+    // The atlas gives the size of the glyphs, and must outlive the font
+    FontData(GlyphAtlas& atlas);
     ~FontData(void);
     // Add a glyph at a code point
     void addGlyph(char32_t codePoint,
@@ -23,22 +30,77 @@ namespace LRTerminal
     void addGlyphs(char32_t codePointStart,
                    const uint8_t* const srcImage,
                    unsigned srcWidth, unsigned srcHeight);
-    // Get a glyph from a codePoint
-    const Glyph& getGlyph(char32_t codePoint) const;
+    // Add glyphs already stored in the atlas, the glyph firstGlyph + glyphs[i] is set at codePoints[i]
+    // The font adds its own references to the glyphs.
+    // If isResolved is false, the table of findGlyph is left for a call to resolve() after other changes.
+    void setGlyphs(const char32_t* const codePoints, const unsigned* const glyphs,
+                   const unsigned firstGlyph, const unsigned count, const bool isResolved = true);
+    // Get a glyph from a codePoint, or the blank glyph if the font does not have it
+    Glyph getGlyph(char32_t codePoint) const;
     // Get the character sizes of the font
     unsigned getGlyphWidth() const;
     unsigned getGlyphHeight() const;
     // Check if a font have a glyph at given code point
     bool hasGlyph(char32_t codePoint) const;
+
+    // Fallback
+    // Set the font used for the glyphs this font does not have, NULL for none
+    // The fallback font must have the same glyph size and must not itself have a fallback.
+    // If isResolved is false, the table of findGlyph is left for a call to resolve() after other changes.
+    void setFallback(const FontData* fallback, const bool isResolved = true);
+    // Compute the table of findGlyph, it is done when adding glyphs or setting the fallback
+    // but must be done again when the glyphs of the fallback font change
+    void resolve(void);
+    // Get the glyph of a code point from this font, or from the fallback font, or the blank glyph
+    Glyph findGlyph(const char32_t codePoint) const;
+
   private:
+    // Number of code points in a page of glyphs, and number of blocks for all the code points
+    static const unsigned C_PAGE_SHIFT = 8u;
+    static const unsigned C_PAGE_SIZE = 1u << C_PAGE_SHIFT;
+    static const unsigned C_BLOCK_COUNT = 0x110000u >> C_PAGE_SHIFT;
+    // Index of a missing glyph
+    static const uint32_t C_NO_GLYPH = ~0u;
+    typedef std::array<uint32_t, C_PAGE_SIZE> GlyphPage;
+    // Two-level table of glyph indexes in the atlas, the page 0 is the page of the blocks without glyphs
+    struct GlyphTable
+    {
+      std::vector<uint16_t> blocks; // Page of each block
+      std::vector<GlyphPage> pages;
+      void reset(const uint32_t missingGlyph);
+      uint32_t get(const char32_t codePoint) const;
+      void set(const char32_t codePoint, const uint32_t glyph);
+    };
+
+    void _addGlyph(char32_t codePoint,
+                   const uint8_t* const srcImage,
+                   unsigned srcWidth, unsigned srcHeight,
+                   unsigned srcX, unsigned srcY);
     bool _checkIsBlank(const uint8_t* const srcImage,
                        unsigned srcWidth, unsigned srcHeight,
                        unsigned srcX, unsigned srcY) const;
+    GlyphAtlas& m_atlas; // Storage of the glyph images, the glyph 0 is the blank glyph
     unsigned m_glyphWidth;
     unsigned m_glyphHeight;
-    std::map<char32_t, Glyph> m_glyphMap;
+    GlyphTable m_ownGlyphs; // Glyphs of the font, C_NO_GLYPH if missing
+    GlyphTable m_resolvedGlyphs; // Glyphs of the font or of the fallback font, the blank glyph if missing
+    const FontData* m_fallback;
   };
 
+  ////
+  // Inline implementations
+  inline uint32_t FontData::GlyphTable::get(const char32_t codePoint) const
+  {
+    return pages[blocks[codePoint >> C_PAGE_SHIFT]][codePoint & (C_PAGE_SIZE - 1u)];
+  }
+
+  inline Glyph FontData::findGlyph(const char32_t codePoint) const
+  {
+    // The code points above U+10FFFF are not characters
+    const uint32_t index = (codePoint < (C_BLOCK_COUNT << C_PAGE_SHIFT)) ? m_resolvedGlyphs.get(codePoint) : 0u;
+    return m_atlas.getGlyph(index);
+  }
+
 }
 
 #endif
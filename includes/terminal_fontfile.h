@@ -0,0 +1,64 @@
+#ifndef _TERMINAL_FONTFILE__H_
+#define _TERMINAL_FONTFILE__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Loading of bitmap font files at runtime: BDF and PSF2
+// A parsed font is written to a binary cache, so the next loads of the same file only map the cache.
+// The cache is a header followed by the code points and the glyph images, in the format of the glyph atlas,
+// it is valid as long as the size and modification time of the font file do not change.
+namespace LRTerminal::FontFile
+{
+  // Font file formats
+  enum class Format
+  {
+    UNKNOWN,
+    BDF,
+    PSF2,
+  };
+
+  // Glyphs of a font file, as monochrome images of glyphWidth * glyphHeight pixels
+  // Each row of an image is (glyphWidth + 7) / 8 bytes, the first pixel of a row is the lowest bit
+  // of its first byte, see Glyph::getBits. Several code points can use the same image.
+  struct BitmapFont
+  {
+    unsigned glyphWidth;
+    unsigned glyphHeight;
+    std::vector<char32_t> codePoints; // Code points of the font, without the blank glyphs
+    std::vector<uint32_t> glyphs; // Index of the image of each code point
+    std::vector<uint8_t> bits; // Images of the glyphs, one after another
+
+    // Number of bytes of the image of a glyph
+    unsigned getGlyphSize(void) const;
+    // Number of images
+    unsigned getImageCount(void) const;
+    // Copy of the font with glyphs of another size, the glyphs are centered, and cropped if too large
+    BitmapFont resize(const unsigned width, const unsigned height) const;
+  };
+
+  // Scale count monochrome images of srcWidth * srcHeight pixels, in the layout of BitmapFont::bits,
+  // to images of width * height pixels appended to out. A pixel is set if the set source pixels cover
+  // at least 3/8 of its area, so the strokes of one pixel are kept when the glyphs are made smaller.
+  void scaleImages(const uint8_t* const bits, const unsigned count,
+                   const unsigned srcWidth, const unsigned srcHeight,
+                   const unsigned width, const unsigned height, std::vector<uint8_t>& out);
+
+  // Format of font file data, from its header
+  Format getFormat(const uint8_t* const data, const size_t size);
+  // Parse font file data, returns false if the data is not a valid font
+  bool parseBDF(const char* const data, const size_t size, BitmapFont& font);
+  bool parsePSF2(const uint8_t* const data, const size_t size, BitmapFont& font);
+  bool parse(const uint8_t* const data, const size_t size, BitmapFont& font);
+
+  // Load a font file, from its cache in cacheDirectory if it is valid
+  // A new cache is written after parsing the file, there is no cache if cacheDirectory is empty.
+  // Returns false if the file can not be read or is not a valid font.
+  bool load(const std::string& path, const std::string& cacheDirectory, BitmapFont& font);
+  // Path of the cache of a font file
+  std::string getCachePath(const std::string& path, const std::string& cacheDirectory);
+}
+
+#endif
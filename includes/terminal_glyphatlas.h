@@ -0,0 +1,128 @@
+#ifndef _TERMINAL_GLYPHATLAS__H_
+#define _TERMINAL_GLYPHATLAS__H_
+
+#include "terminal_glyphs.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace LRTerminal
+{
+  // Alignment of the glyph images in an atlas, a cache line
+  const unsigned C_GLYPH_ATLAS_ALIGNMENT(64u);
+  // Alignment of the monochrome glyph images in an atlas, a SSE register
+  const unsigned C_MONOCHROME_GLYPH_ALIGNMENT(16u);
+
+  // Storage of the glyph images of all the fonts, all of the same size
+  // The monochrome glyphs, whose pixels are all 0x00 or 0xFF, are stored with 1 bit per pixel,
+  // the other ones as alpha masks of 1 byte per pixel, see Glyph.
+  // The images of each kind are packed back to back in a single aligned buffer, and addressed by index.
+  // The glyph 0 is the blank glyph, and the slots of the removed glyphs are reused.
+  // The glyphs are deduplicated by content: adding an image already stored gives the same index,
+  // and the glyphs are reference counted, so several fonts can share their identical glyphs.
+  class GlyphAtlas
+  {
+  public:
+    // Constructor
+    GlyphAtlas(const unsigned glyphWidth, const unsigned glyphHeight);
+
+    // Add a glyph from a source alpha mask, srcX and srcY are the position in pixels of the glyph in the source image
+    // Returns the index of the glyph, with a reference owned by the caller
+    unsigned addGlyph(const uint8_t* const srcImage,
+                      const unsigned srcWidth, const unsigned srcHeight,
+                      const unsigned srcX, const unsigned srcY);
+    // Add glyphs from packed alpha masks of glyphWidth * glyphHeight bytes each
+    // Returns the index of the first glyph, the glyphs have consecutive indexes and are not deduplicated.
+    unsigned addGlyphs(const uint8_t* const images, const unsigned count);
+    // Add monochrome glyphs from packed images of getMonochromeGlyphSize() bytes each, see Glyph::getBits
+    // Returns the index of the first glyph, the glyphs have consecutive indexes and are not deduplicated.
+    unsigned addMonochromeGlyphs(const uint8_t* const images, const unsigned count);
+    // Add a reference to a glyph
+    void retainGlyph(const unsigned index);
+    // Remove a reference to a glyph, when it has no reference left its index may be given to another glyph
+    void removeGlyph(const unsigned index);
+    // Reserve the storage for a number of glyphs of each kind
+    void reserve(const unsigned count, const unsigned monochromeCount);
+
+    // Getters
+    unsigned getGlyphWidth(void) const;
+    unsigned getGlyphHeight(void) const;
+    // Number of bytes of a monochrome glyph image, without the padding
+    unsigned getMonochromeGlyphSize(void) const;
+    // Number of glyph slots of each kind, including the removed glyphs
+    unsigned getGlyphCount(void) const;
+    unsigned getMonochromeGlyphCount(void) const;
+    // Memory of the glyph images, including the padding
+    size_t getStoredBytes(void) const;
+    // Memory saved by the deduplication, the size of the images of the references to shared glyphs
+    size_t getSharedBytes(void) const;
+    // Check if a glyph is stored with 1 bit per pixel
+    static bool isMonochrome(const unsigned index);
+    // Get a glyph, valid until a glyph is added
+    Glyph getGlyph(const unsigned index) const;
+
+  private:
+    // Flag of the index of the glyphs stored as alpha masks
+    static const unsigned C_ALPHA_GLYPH = 0x80000000u;
+    // Units of storage, so the buffers are aligned
+    struct alignas(C_GLYPH_ATLAS_ALIGNMENT) Block
+    {
+      uint8_t bytes[C_GLYPH_ATLAS_ALIGNMENT];
+    };
+    struct alignas(C_MONOCHROME_GLYPH_ALIGNMENT) MonochromeBlock
+    {
+      uint8_t bytes[C_MONOCHROME_GLYPH_ALIGNMENT];
+    };
+
+    // Content hash of an image, the monochrome and alpha mask images have different hashes
+    static uint64_t _hash(const uint8_t* const image, const unsigned size, const bool isMonochrome);
+    // Index the glyphs added in bulk, they are indexed when a glyph is added one by one
+    void _indexGlyphs(void);
+    // Find a stored glyph with the same image, returns false if there is none
+    bool _findGlyph(const uint64_t hash, const uint8_t* const image, const bool isMonochrome, unsigned& index) const;
+    // Check if an alpha mask only has fully transparent or opaque pixels
+    bool _isMonochrome(const uint8_t* const srcImage, const unsigned srcWidth,
+                       const unsigned srcX, const unsigned srcY) const;
+    // Get a slot for a new glyph, its image is blank
+    unsigned _allocate(void);
+    unsigned _allocateMonochrome(void);
+    uint8_t* _getImage(const unsigned index);
+    uint8_t* _getBits(const unsigned index);
+    uint32_t& _getReferences(const unsigned index);
+
+    unsigned m_glyphWidth;
+    unsigned m_glyphHeight;
+    unsigned m_bytesPerRow; // Bytes of a row of a monochrome glyph
+    unsigned m_blocksPerGlyph;
+    unsigned m_monochromeBlocksPerGlyph;
+    std::vector<Block> m_blocks;
+    std::vector<MonochromeBlock> m_monochromeBlocks;
+    std::vector<unsigned> m_freeGlyphs; // Slots of the removed glyphs, as glyph indexes
+    std::vector<uint32_t> m_references; // Reference count of each glyph, 0 for a free slot
+    std::vector<uint32_t> m_monochromeReferences;
+    std::unordered_map<uint64_t, unsigned> m_glyphsByHash; // Stored glyphs by content hash
+    bool m_isIndexed; // False if glyphs have been added in bulk since the glyphs were indexed
+    size_t m_sharedReferences; // References beyond the first one of each glyph, by kind
+    size_t m_sharedMonochromeReferences;
+  };
+
+  ////
+  // Inline implementations
+  inline bool GlyphAtlas::isMonochrome(const unsigned index)
+  {
+    return (index & C_ALPHA_GLYPH) == 0u;
+  }
+
+  inline Glyph GlyphAtlas::getGlyph(const unsigned index) const
+  {
+    if (isMonochrome(index))
+    {
+      return Glyph(m_glyphWidth, m_glyphHeight, NULL, m_monochromeBlocks[index * m_monochromeBlocksPerGlyph].bytes);
+    }
+    return Glyph(m_glyphWidth, m_glyphHeight, m_blocks[(index & ~C_ALPHA_GLYPH) * m_blocksPerGlyph].bytes, NULL);
+  }
+
+}
+
+#endif
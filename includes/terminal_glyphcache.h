@@ -0,0 +1,88 @@
+#ifndef _TERMINAL_GLYPHCACHE__H_
+#define _TERMINAL_GLYPHCACHE__H_
+
+#include "terminal_color.h"
+#include "terminal_textstyle.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+namespace LRTerminal
+{
+  // Default number of tiles kept in a glyph cache
+  const unsigned C_GLYPH_CACHE_CAPACITY(1024u);
+
+  // Cache of already rendered glyph tiles
+  // A tile is a glyph blended with a foreground and background color, stored in the XRGB_8888 format.
+  // The tiles are indexed by (font, code point, foreground, background),
+  // the least recently used tile is evicted when the cache is full.
+  class GlyphCache
+  {
+  public:
+    // Constructor
+    GlyphCache(const unsigned tileWidth, const unsigned tileHeight,
+               const unsigned capacity = C_GLYPH_CACHE_CAPACITY);
+    // Destructor
+    ~GlyphCache();
+
+    // The colors are given as XRGB
+    // Get the tile for a cell, or NULL if the tile is not in the cache
+    const uint32_t* find(const Font font, const char32_t codePoint,
+                         const uint32_t foreground, const uint32_t background);
+    // Reserve a tile for a cell, the returned buffer must be filled by the caller
+    // The least recently used tile is evicted if the cache is full
+    uint32_t* insert(const Font font, const char32_t codePoint,
+                     const uint32_t foreground, const uint32_t background);
+    // Remove all the tiles, for example when a glyph has changed
+    void clear(void);
+
+    // Getters
+    unsigned getTileWidth(void) const;
+    unsigned getTileHeight(void) const;
+    unsigned getCapacity(void) const;
+    unsigned getSize(void) const;
+    // Statistics
+    uint64_t getHits(void) const;
+    uint64_t getMisses(void) const;
+    uint64_t getEvictions(void) const;
+    void resetStatistics(void);
+
+  private:
+    // Key of a tile
+    struct Key
+    {
+      uint64_t glyph; // code point and font
+      uint64_t colors; // foreground and background, as XRGB
+      bool operator==(const Key& that) const;
+    };
+    struct KeyHash
+    {
+      size_t operator()(const Key& key) const;
+    };
+    static Key _makeKey(const Font font, const char32_t codePoint,
+                        const uint32_t foreground, const uint32_t background);
+
+    // Least recently used list handling, the list is stored in m_prev and m_next
+    void _unlink(const unsigned slot);
+    void _pushFront(const unsigned slot);
+
+    unsigned m_tileWidth;
+    unsigned m_tileHeight;
+    unsigned m_capacity;
+    unsigned m_size; // Number of slots in use
+    std::vector<uint32_t> m_tiles; // Tile images, size = capacity * tileWidth * tileHeight
+    std::vector<Key> m_keys; // Key of each slot
+    std::vector<unsigned> m_prev; // Previous slot in the LRU list
+    std::vector<unsigned> m_next; // Next slot in the LRU list
+    unsigned m_head; // Most recently used slot
+    unsigned m_tail; // Least recently used slot
+    std::unordered_map<Key, unsigned, KeyHash> m_index; // Key -> slot
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_evictions;
+  };
+
+}
+
+#endif
@@ -1,35 +1,80 @@
-
 #ifndef _TERMINAL_GLYPHS__H_
 #define _TERMINAL_GLYPHS__H_
 
+#include <cstddef>
 #include <cstdint>
 
 namespace LRTerminal
 {
   // Base class for the font
   // Each glyph represents a character
+  // A glyph is a view of an image stored in a GlyphAtlas, it is valid until a glyph is added to the atlas
+  // The image is either an alpha mask, or a bitmask for the monochrome glyphs.
   class Glyph
   {
   public:
-    // Constructor
-     // Blank glyph
-    Glyph(unsigned width, unsigned height);
-     // Glyph from a source image, scrX and scrY are the position in pixels of the glyph in the source image
-    Glyph(unsigned width, unsigned height,
-          const uint8_t* const srcImage,
-          unsigned srcWidth, unsigned srcHeight, unsigned srcX, unsigned srcY);
-    // Destructor
-    ~Glyph();
+    // Constructor, one of image or bits is NULL
+    Glyph(const unsigned width, const unsigned height, const uint8_t* const image, const uint8_t* const bits);
 
     // Get the data
     unsigned getWidth(void) const;
     unsigned getHeight(void) const;
+    bool isMonochrome(void) const;
+    // Alpha mask, NULL for a monochrome glyph
     const uint8_t* getImage(void) const;
+    // Bitmask of a monochrome glyph, NULL otherwise
+    // Each row is (width + 7) / 8 bytes, the first pixel of a row is the lowest bit of its first byte.
+    const uint8_t* getBits(void) const;
+    // Alpha of a pixel, for both kinds of glyphs
+    uint8_t getPixel(const unsigned x, const unsigned y) const;
   private:
     unsigned m_width;
     unsigned m_height;
-    uint8_t* m_image; // Glyph image as a greyscale image of size width * height, representing an alpha mask
+    const uint8_t* m_image; // Glyph image as a greyscale image of size width * height, representing an alpha mask
+    const uint8_t* m_bits; // Glyph image with 1 bit per pixel
   };
+
+  ////
+  // Inline implementations
+  inline Glyph::Glyph(const unsigned width, const unsigned height, const uint8_t* const image, const uint8_t* const bits):
+      m_width(width), m_height(height), m_image(image), m_bits(bits)
+  {
+  }
+
+  inline unsigned Glyph::getWidth(void) const
+  {
+    return m_width;
+  }
+
+  inline unsigned Glyph::getHeight(void) const
+  {
+    return m_height;
+  }
+
+  inline bool Glyph::isMonochrome(void) const
+  {
+    return m_bits != NULL;
+  }
+
+  inline const uint8_t* Glyph::getImage(void) const
+  {
+    return m_image;
+  }
+
+  inline const uint8_t* Glyph::getBits(void) const
+  {
+    return m_bits;
+  }
+
+  inline uint8_t Glyph::getPixel(const unsigned x, const unsigned y) const
+  {
+    if (m_bits != NULL)
+    {
+      const uint8_t byte = m_bits[(y * ((m_width + 7u) / 8u)) + (x / 8u)];
+      return ((byte >> (x % 8u)) & 1u) ? 0xFFu : 0x00u;
+    }
+    return m_image[(y * m_width) + x];
+  }
 }
 
 #endif
@@ -66,10 +66,13 @@ namespace LRTerminal {
     // Custom font
     virtual void addToCustomFont(const char32_t startingCodePoint,
                                  const unsigned width, const unsigned height,
-                                 const unsigned char* const image);
+                                 const unsigned char* const image,
+                                 const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
     virtual void addXBMToCustomFont(const char32_t startingCodePoint,
                                     const unsigned width, const unsigned height,
-                                    const unsigned char* const image);
+                                    const unsigned char* const image,
+                                    const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
+    virtual bool addFontFileToCustomFont(const char* const path);
 
     // For the log interface
     void log(const LogLevel level, const std::string& msg) const;
@@ -89,6 +92,11 @@ namespace LRTerminal {
      */
     bool _environment(unsigned cmd, void *data) const;
 
+    /* Read the core options and apply them */
+    void _applyCoreOptions(void);
+    /* Read the size of the cells from the core options */
+    void _getCellSize(unsigned& width, unsigned& height);
+
     /* Video Refresh
      * Render a frame.
      *
@@ -174,6 +182,8 @@ namespace LRTerminal {
     std::string m_libraryVersion;
     /* Valid extensions */
     std::string m_validExtensions;
+    /* Directory of the caches of the font files, empty if there is none */
+    std::string m_fontCacheDirectory;
   };
 
 }
@@ -4,6 +4,9 @@
 
 #include "terminal_console.h"
 #include "terminal_builtin_fonts.h"
+#include "terminal_glyphcache.h"
+#include "terminal_workerpool.h"
+#include <vector>
 
 namespace LRTerminal
 {
@@ -13,29 +16,85 @@ namespace LRTerminal
   {
   public:
     // Constructors, destructors
-    RootConsole(const unsigned width, const unsigned height);
+    // The size of the cells in pixels is fixed for the lifetime of the console
+    RootConsole(const unsigned width, const unsigned height,
+                const unsigned cellWidth = C_GLYPH_WIDTH, const unsigned cellHeight = C_GLYPH_HEIGHT);
     virtual ~RootConsole();
 
     // Render the console into a buffer and returns the buffer
     // Each unsigned represents a pixel in the XRGB_8888 format
     // isUpdated is set to true if the image has been updated since last call, false otherwise
     const uint32_t* renderImage(bool& isUpdate);
+    // Copy the rendered image into another buffer, of pitch bytes per row, for example the framebuffer of the frontend
+    // The whole image is copied, the previous content of the buffer is not used
+    void copyImage(uint32_t* const target, const size_t pitch) const;
 
     // Get Font width & height
     const unsigned getFontWidth(void) const;
     const unsigned getFontHeight(void) const;
 
-    // Custom font
+    // Custom font, the sheets are cut in glyphs of glyphWidth x glyphHeight, which are resized to the cells
     void addToCustomFont(const char32_t startingCodePoint,
                          const unsigned width, const unsigned height,
-                         const unsigned char* const image);
+                         const unsigned char* const image,
+                         const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
     void addXBMToCustomFont(const char32_t startingCodePoint,
                             const unsigned width, const unsigned height,
-                            const unsigned char* const image);
+                            const unsigned char* const image,
+                            const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT);
+    void addToCustomFont(const FontFile::BitmapFont& font);
+
+    // Number of threads used for rendering, 1 renders on the calling thread
+    // The console is split into fixed horizontal bands of cell rows, one per thread
+    void setRenderThreads(const unsigned threadCount);
+    unsigned getRenderThreads(void) const;
+
+    // Caches of the rendered glyphs (one per band), for statistics
+    unsigned getGlyphCacheCount(void) const;
+    const GlyphCache& getGlyphCache(const unsigned band = 0u) const;
+    // Fonts used by the console, for statistics
+    const BuiltinFonts& getBuiltinFonts(void) const;
+
+  protected:
+    // Move the matching pixels of the framebuffer, so only the uncovered cells are rendered
+    virtual void _onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                           const int dx, const int dy);
 
   private:
+    // Copy constructor & operator = are declared but not implemented
+    RootConsole(const RootConsole& that);
+    RootConsole& operator=(const RootConsole& that);
+
+    // Content of a cell as it is in the framebuffer
+    struct RenderedCell
+    {
+      char32_t codePoint;
+      uint32_t foreground; // XRGB
+      uint32_t background; // XRGB
+      Font font;
+    };
+
+    // Render the dirty cells of the rows [firstRow; lastRow[, returns true if a cell has been rendered
+    // The common cell sizes have their own version, where the size is a constant,
+    // the version for a size of 0 * 0 uses the size of the console.
+    template <unsigned CellWidth, unsigned CellHeight>
+    bool _renderRows(const unsigned firstRow, const unsigned lastRow, GlyphCache& glyphCache);
+    typedef bool (RootConsole::*RenderRowsFunction)(const unsigned, const unsigned, GlyphCache&);
+    // Version of _renderRows for a cell size
+    static RenderRowsFunction _getRenderRowsFunction(const unsigned cellWidth, const unsigned cellHeight);
+    // Remove the tiles from all the caches and force all the cells to be rendered again
+    void _invalidateRenderedCells(void);
+
+    unsigned m_cellWidth; // Size of the cells in pixels
+    unsigned m_cellHeight;
+    RenderRowsFunction m_renderRows; // Version of _renderRows for the size of the cells
     uint32_t* m_framebuffer; // buffer on which the console is rendered
     BuiltinFonts m_builtinFonts; // The builtin fonts
+    std::vector<RenderedCell> m_renderedCells; // What is currently drawn in the framebuffer, size = width * height
+    bool m_isScrolled; // True if pixels of the framebuffer have been moved since the last rendering
+    std::vector<GlyphCache> m_glyphCaches; // Already blended glyphs, one cache per band
+    std::vector<uint8_t> m_isBandUpdated; // Result of each band for the current frame
+    WorkerPool* m_workerPool; // Render threads, NULL if rendering on the calling thread
   };
 
 }
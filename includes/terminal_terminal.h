@@ -4,6 +4,10 @@
 
 namespace LRTerminal
 {
+  // Font sizes, of the builtin fonts and of the cells by default
+  const unsigned C_GLYPH_WIDTH(8u);
+  const unsigned C_GLYPH_HEIGHT(16u);
+
   // RootConsole buffer, see terminal_console.h
   class Console;
 
@@ -57,13 +61,23 @@ namespace LRTerminal
     // Add glyphs to the custom font (LRTerminal::Font::CUSTOM). The custom font has initially no glyphs
     // The image in parameter represents the alpha mask of the glyphs
     // Each char corresponds to the opacity level of a pixel, 0x00 is transparent, 0xFF is opaque
+    // The image is a sheet of glyphs of glyphWidth x glyphHeight pixels, read from left to right and top to bottom.
+    // The cell size is chosen by the user at runtime, see the "Cell size" core option, C_GLYPH_WIDTH x C_GLYPH_HEIGHT
+    // by default: the glyphs which are not of the size of the cells are centered in the cells, and cropped if too large.
     virtual void addToCustomFont(const char32_t startingCodePoint,
                                  const unsigned width, const unsigned height,
-                                 const unsigned char* const image) = 0;
+                                 const unsigned char* const image,
+                                 const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT) = 0;
     // Add glyphs to he custom font. The glyphs are formatted in a monochrome XBM image
+    // The sheet is laid out and resized as in addToCustomFont
     virtual void addXBMToCustomFont(const char32_t startingCodePoint,
                                     const unsigned width, const unsigned height,
-                                    const unsigned char* const image) = 0;
+                                    const unsigned char* const image,
+                                    const unsigned glyphWidth = C_GLYPH_WIDTH, const unsigned glyphHeight = C_GLYPH_HEIGHT) = 0;
+    // Add the glyphs of a BDF or PSF2 font file to the custom font, returns false if the file can not be loaded
+    // The parsed font is cached in the save directory of the frontend, the next loads of the file are faster.
+    // The glyphs which are not of the size of the cells are centered in the cells, and cropped if too large.
+    virtual bool addFontFileToCustomFont(const char* const path) = 0;
   };
 }
 
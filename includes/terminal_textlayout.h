@@ -0,0 +1,81 @@
+#ifndef _TERMINAL_TEXTLAYOUT__H_
+#define _TERMINAL_TEXTLAYOUT__H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LRTerminal
+{
+  // Default number of layouts kept in a text layout cache
+  const unsigned C_TEXT_LAYOUT_CACHE_CAPACITY(8u);
+
+  // A line of a wrapped text, as a range of code points of the text
+  struct TextLine
+  {
+    unsigned start;
+    unsigned length;
+  };
+
+  // Iterator over the lines of a text wrapped into a given width, without any allocation
+  // The text is split along the spaces, a word is added to a line if the line,
+  // with a space before the word, stays shorter than the width.
+  // The first word of a line is always added, even if it is too long.
+  class LineBreaker
+  {
+  public:
+    // Constructor, the text must outlive the iterator
+    LineBreaker(const std::u32string_view text, const unsigned width);
+
+    // Get the next line, false if there is no line left
+    bool next(TextLine& line);
+
+  private:
+    std::u32string_view m_text;
+    unsigned m_width;
+    size_t m_position; // Start of the next line, greater than the text size after the last line
+  };
+
+  // Cache of the lines of wrapped texts
+  // A layout is found by the hash of the text and the width, and the text is compared to avoid collisions.
+  // The least recently used layout is replaced when the cache is full, and its storage is reused,
+  // so the same texts can be wrapped each frame without any allocation.
+  class TextLayoutCache
+  {
+  public:
+    // Constructor
+    TextLayoutCache(const unsigned capacity = C_TEXT_LAYOUT_CACHE_CAPACITY);
+
+    // Lines of a text wrapped into a width, see LineBreaker
+    // The lines are valid until the next call
+    const std::vector<TextLine>& getLines(const std::u32string_view text, const unsigned width);
+    // Remove all the layouts
+    void clear(void);
+
+    // Statistics
+    uint64_t getHits(void) const;
+    uint64_t getMisses(void) const;
+
+  private:
+    struct Entry
+    {
+      uint64_t hash;
+      unsigned width;
+      uint64_t lastUse; // Value of the use counter at the last access, 0 if the entry is unused
+      std::u32string text;
+      std::vector<TextLine> lines;
+    };
+    static uint64_t _hash(const std::u32string_view text);
+
+    unsigned m_capacity;
+    std::vector<Entry> m_entries; // Allocated at the first use
+    uint64_t m_useCounter;
+    uint64_t m_hits;
+    uint64_t m_misses;
+  };
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _TERMINAL_UTF8__H_
+#define _TERMINAL_UTF8__H_
+
+#include <cstddef>
+#include <string>
+
+namespace LRTerminal::Utf8
+{
+  // Code point replacing the invalid sequences
+  const char32_t C_REPLACEMENT_CHARACTER(0xFFFDu);
+
+  // Number of bytes at the start of a string that are ASCII characters
+  size_t getAsciiLength(const char* const str, const size_t size);
+  // Decode the code point starting at it, and move it after the code point
+  // Each maximal invalid subsequence is decoded as C_REPLACEMENT_CHARACTER
+  char32_t decode(const char*& it, const char* const end);
+  // Number of code points of a string
+  size_t getLength(const char* const str, const size_t size);
+  // Call function(codePoint) for each code point of a string
+  template <typename Function>
+  void forEachCodePoint(const char* const str, const size_t size, Function function);
+  // Decode a string, the storage of the output string is reused
+  void decode(const char* const str, const size_t size, std::u32string& out);
+
+  ////
+  // Template implementations
+  template <typename Function>
+  void forEachCodePoint(const char* const str, const size_t size, Function function)
+  {
+    const char* it = str;
+    const char* const end = str + size;
+    while (it != end)
+    {
+      // The runs of ASCII characters are found by blocks
+      const size_t asciiLength = getAsciiLength(it, end - it);
+      for (const char* const asciiEnd = it + asciiLength; it != asciiEnd; ++it)
+      {
+        function(static_cast<char32_t>(*it));
+      }
+      if (it != end)
+      {
+        function(decode(it, end));
+      }
+    }
+  }
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 // Various utility functions
 
+#include <cstring>
+
 namespace LRTerminal::Utils
 {
 
@@ -26,6 +28,42 @@ namespace LRTerminal::Utils
     return (a + ((b - a) * coef));
   }
 
+  // Move the content of the rectangle [x0; x1[ x [y0; y1[ of a 2D array by (dx, dy)
+  // Pitch is the number of elements between two rows. Only the elements inside the rectangle are written,
+  // those uncovered by the move are left unchanged. The move must be smaller than the rectangle.
+  template <typename T> void moveRect(T* const data, const unsigned pitch,
+                                      const unsigned x0, const unsigned y0,
+                                      const unsigned x1, const unsigned y1,
+                                      const int dx, const int dy)
+  {
+    // Destination columns and rows
+    const unsigned xStart = (dx > 0) ? x0 + dx : x0;
+    const unsigned xEnd = (dx < 0) ? x1 + dx : x1;
+    const unsigned yStart = (dy > 0) ? y0 + dy : y0;
+    const unsigned yEnd = (dy < 0) ? y1 + dy : y1;
+    const size_t size = (xEnd - xStart) * sizeof(T);
+    if ((dx == 0) && (x0 == 0u) && (x1 == pitch))
+    {
+      // Full rows, the moved area is contiguous
+      memmove(data + (yStart * pitch), data + ((yStart - dy) * pitch), (yEnd - yStart) * size);
+      return;
+    }
+    for (unsigned i = yStart; i < yEnd; ++i)
+    {
+      // When moving down, the rows are copied from the bottom so they are read before being overwritten
+      const unsigned row = (dy > 0) ? (yEnd - 1u - (i - yStart)) : i;
+      const T* const src = data + ((row - dy) * pitch) + (xStart - dx);
+      T* const dst = data + (row * pitch) + xStart;
+      memmove(dst, src, size);
+    }
+  }
+
+  // Move count elements, the source and destination may overlap
+  template <typename T> void moveCells(T* const dst, const T* const src, const unsigned count)
+  {
+    memmove(dst, src, count * sizeof(T));
+  }
+
 }
 
 
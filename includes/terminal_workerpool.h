@@ -0,0 +1,53 @@
+#ifndef _TERMINAL_WORKERPOOL__H_
+#define _TERMINAL_WORKERPOOL__H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+namespace LRTerminal
+{
+  // Pool of persistent threads, used to split a task into independent jobs
+  // The thread calling run() also executes jobs, so a pool of N threads creates N-1 workers
+  class WorkerPool
+  {
+  public:
+    // Constructor, destructor
+    WorkerPool(const unsigned threadCount);
+    ~WorkerPool();
+
+    // Number of threads executing the jobs, including the calling thread
+    unsigned getThreadCount(void) const;
+
+    // Execute job(index) for each index in [0; jobCount[, and wait for all the jobs to be done
+    void run(const unsigned jobCount, const std::function<void(const unsigned)>& job);
+
+  private:
+    // Copy constructor & operator = are declared but not implemented
+    WorkerPool(const WorkerPool& that);
+    WorkerPool& operator=(const WorkerPool& that);
+
+    // Main loop of the worker threads
+    void _workerLoop(void);
+    // Execute jobs until there are none left
+    void _executeJobs(void);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition; // Signaled when jobs are available
+    std::condition_variable m_doneCondition; // Signaled when the last worker is done
+    const std::function<void(const unsigned)>* m_job; // Current job, valid during run()
+    unsigned m_jobCount;
+    std::atomic<unsigned> m_nextJob; // Next job index to execute
+    unsigned m_busyWorkers; // Workers that have not finished the current run
+    uint64_t m_generation; // Incremented at each run, for waking up the workers
+    bool m_isStopping;
+  };
+
+}
+
+#endif
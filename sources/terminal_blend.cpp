@@ -0,0 +1,393 @@
+#include "terminal_blend.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TERMINAL_BLEND_X86
+#include <immintrin.h>
+#endif
+
+namespace LRTerminal::Blend
+{
+  typedef void (*BlendRowFunction)(const uint8_t* const alpha, const unsigned width,
+                                   const Color& background, const Color& foreground,
+                                   uint32_t* const out);
+  typedef void (*LerpRowFunction)(const uint32_t* const a, const uint32_t* const b,
+                                  const uint16_t* const weights, const unsigned width,
+                                  uint32_t* const out);
+  typedef void (*SelectRowsFunction)(const uint8_t* const bits, const unsigned width, const unsigned height,
+                                     const uint32_t background, const uint32_t foreground,
+                                     uint32_t* const out);
+
+  ////
+  // Scalar kernel, reference for the other kernels
+  // Each pixel is Color::lerpXRGB(background, foreground, Color::alphaToWeight(alpha))
+  static void _blendRowScalar(const uint8_t* const alpha, const unsigned width,
+                              const Color& background, const Color& foreground,
+                              uint32_t* const out)
+  {
+    const uint32_t back = background.toXRGB();
+    const uint32_t fore = foreground.toXRGB();
+    for (unsigned i = 0u; i < width; ++i)
+    {
+      out[i] = Color::lerpXRGB(back, fore, Color::alphaToWeight(alpha[i]));
+    }
+  }
+
+  static void _lerpRowScalar(const uint32_t* const a, const uint32_t* const b,
+                             const uint16_t* const weights, const unsigned width,
+                             uint32_t* const out)
+  {
+    for (unsigned i = 0u; i < width; ++i)
+    {
+      out[i] = Color::lerpXRGB(a[i], b[i], weights[i]);
+    }
+  }
+
+  // Pixels i to width - 1 of a row of a bitmask
+  static inline void _selectPixelsScalar(const uint8_t* const bits, unsigned i, const unsigned width,
+                                         const uint32_t background, const uint32_t foreground,
+                                         uint32_t* const out)
+  {
+    for (; i < width; ++i)
+    {
+      out[i] = ((bits[i / 8u] >> (i % 8u)) & 1u) ? foreground : background;
+    }
+  }
+
+  static void _selectRowsScalar(const uint8_t* const bits, const unsigned width, const unsigned height,
+                                const uint32_t background, const uint32_t foreground,
+                                uint32_t* const out)
+  {
+    const unsigned bytesPerRow = (width + 7u) / 8u;
+    for (unsigned j = 0u; j < height; ++j)
+    {
+      _selectPixelsScalar(bits + (j * bytesPerRow), 0u, width, background, foreground, out + (j * width));
+    }
+  }
+
+#ifdef TERMINAL_BLEND_X86
+  ////
+  // SSE2 kernel, 8 pixels by iteration
+  // Each component is computed in 16 bits: (back * (256 - weight) + fore * weight) >> 8
+  // Both products fit in 16 bits unsigned, as does their sum
+  __attribute__((target("sse2")))
+  static inline __m128i _lerpComponentSSE2(const uint8_t back, const uint8_t fore,
+                                           const __m128i weight, const __m128i invWeight)
+  {
+    const __m128i ret = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(back), invWeight),
+                                      _mm_mullo_epi16(_mm_set1_epi16(fore), weight));
+    return _mm_srli_epi16(ret, 8);
+  }
+
+  __attribute__((target("sse2")))
+  static void _blendRowSSE2(const uint8_t* const alpha, const unsigned width,
+                            const Color& background, const Color& foreground,
+                            uint32_t* const out)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxWeight = _mm_set1_epi16(256);
+    unsigned i = 0u;
+    for (; (i + 8u) <= width; i += 8u)
+    {
+      // Weights from the alpha levels: alpha + (alpha >> 7)
+      const __m128i alpha16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha + i)), zero);
+      const __m128i weight = _mm_add_epi16(alpha16, _mm_srli_epi16(alpha16, 7));
+      const __m128i invWeight = _mm_sub_epi16(maxWeight, weight);
+      // Interpolate each component
+      const __m128i red = _lerpComponentSSE2(background.getRed(), foreground.getRed(), weight, invWeight);
+      const __m128i green = _lerpComponentSSE2(background.getGreen(), foreground.getGreen(), weight, invWeight);
+      const __m128i blue = _lerpComponentSSE2(background.getBlue(), foreground.getBlue(), weight, invWeight);
+      // Interleave into XRGB pixels
+      const __m128i greenBlue = _mm_or_si128(_mm_slli_epi16(green, 8), blue);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(greenBlue, red));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4u), _mm_unpackhi_epi16(greenBlue, red));
+    }
+    // Remaining pixels
+    _blendRowScalar(alpha + i, width - i, background, foreground, out + i);
+  }
+
+  // Interpolation of colors, 4 colors by iteration
+  // The components are unpacked to 16 bits, each color having its own weight
+  __attribute__((target("sse2")))
+  static inline __m128i _lerpColorsSSE2(const __m128i a, const __m128i b,
+                                        const __m128i weight, const __m128i invWeight)
+  {
+    const __m128i ret = _mm_add_epi16(_mm_mullo_epi16(a, invWeight), _mm_mullo_epi16(b, weight));
+    return _mm_srli_epi16(ret, 8);
+  }
+
+  __attribute__((target("sse2")))
+  static void _lerpRowSSE2(const uint32_t* const a, const uint32_t* const b,
+                           const uint16_t* const weights, const unsigned width,
+                           uint32_t* const out)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxWeight = _mm_set1_epi16(256);
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    unsigned i = 0u;
+    for (; (i + 4u) <= width; i += 4u)
+    {
+      const __m128i colorsA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      const __m128i colorsB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      // Each weight is repeated for the 4 components of its color
+      const __m128i weight16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights + i));
+      const __m128i weightPairs = _mm_unpacklo_epi16(weight16, weight16);
+      const __m128i weightLow = _mm_unpacklo_epi32(weightPairs, weightPairs);
+      const __m128i weightHigh = _mm_unpackhi_epi32(weightPairs, weightPairs);
+      const __m128i low = _lerpColorsSSE2(_mm_unpacklo_epi8(colorsA, zero), _mm_unpacklo_epi8(colorsB, zero),
+                                          weightLow, _mm_sub_epi16(maxWeight, weightLow));
+      const __m128i high = _lerpColorsSSE2(_mm_unpackhi_epi8(colorsA, zero), _mm_unpackhi_epi8(colorsB, zero),
+                                           weightHigh, _mm_sub_epi16(maxWeight, weightHigh));
+      // The X byte is always 0, like Color::lerpXRGB
+      const __m128i ret = _mm_and_si128(_mm_packus_epi16(low, high), rgbMask);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), ret);
+    }
+    // Remaining colors
+    _lerpRowScalar(a + i, b + i, weights + i, width - i, out + i);
+  }
+
+  // Selection of colors, 8 pixels (a byte of the bitmask) by iteration
+  // The byte is broadcast, each lane tests its bit, and the mask picks the foreground: back ^ ((back ^ fore) & mask)
+  __attribute__((target("sse2")))
+  static void _selectRowsSSE2(const uint8_t* const bits, const unsigned width, const unsigned height,
+                              const uint32_t background, const uint32_t foreground,
+                              uint32_t* const out)
+  {
+    const unsigned bytesPerRow = (width + 7u) / 8u;
+    const __m128i back = _mm_set1_epi32(background);
+    const __m128i diff = _mm_set1_epi32(background ^ foreground);
+    const __m128i bitsLow = _mm_setr_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i bitsHigh = _mm_setr_epi32(0x10, 0x20, 0x40, 0x80);
+    for (unsigned j = 0u; j < height; ++j)
+    {
+      const uint8_t* const rowBits = bits + (j * bytesPerRow);
+      uint32_t* const rowOut = out + (j * width);
+      unsigned i = 0u;
+      for (; (i + 8u) <= width; i += 8u)
+      {
+        const __m128i byte = _mm_set1_epi32(rowBits[i / 8u]);
+        const __m128i maskLow = _mm_cmpeq_epi32(_mm_and_si128(byte, bitsLow), bitsLow);
+        const __m128i maskHigh = _mm_cmpeq_epi32(_mm_and_si128(byte, bitsHigh), bitsHigh);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rowOut + i), _mm_xor_si128(back, _mm_and_si128(diff, maskLow)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rowOut + i + 4u), _mm_xor_si128(back, _mm_and_si128(diff, maskHigh)));
+      }
+      // Remaining pixels of the row
+      _selectPixelsScalar(rowBits, i, width, background, foreground, rowOut);
+    }
+  }
+
+  ////
+  // AVX2 kernel, 16 pixels by iteration
+  __attribute__((target("avx2")))
+  static inline __m256i _lerpComponentAVX2(const uint8_t back, const uint8_t fore,
+                                           const __m256i weight, const __m256i invWeight)
+  {
+    const __m256i ret = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_set1_epi16(back), invWeight),
+                                         _mm256_mullo_epi16(_mm256_set1_epi16(fore), weight));
+    return _mm256_srli_epi16(ret, 8);
+  }
+
+  __attribute__((target("avx2")))
+  static void _blendRowAVX2(const uint8_t* const alpha, const unsigned width,
+                            const Color& background, const Color& foreground,
+                            uint32_t* const out)
+  {
+    const __m256i maxWeight = _mm256_set1_epi16(256);
+    unsigned i = 0u;
+    for (; (i + 16u) <= width; i += 16u)
+    {
+      const __m256i alpha16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + i)));
+      const __m256i weight = _mm256_add_epi16(alpha16, _mm256_srli_epi16(alpha16, 7));
+      const __m256i invWeight = _mm256_sub_epi16(maxWeight, weight);
+      const __m256i red = _lerpComponentAVX2(background.getRed(), foreground.getRed(), weight, invWeight);
+      const __m256i green = _lerpComponentAVX2(background.getGreen(), foreground.getGreen(), weight, invWeight);
+      const __m256i blue = _lerpComponentAVX2(background.getBlue(), foreground.getBlue(), weight, invWeight);
+      // The unpacking works inside each 128 bits lane: pixels 0-3 & 8-11, then 4-7 & 12-15
+      const __m256i greenBlue = _mm256_or_si256(_mm256_slli_epi16(green, 8), blue);
+      const __m256i low = _mm256_unpacklo_epi16(greenBlue, red);
+      const __m256i high = _mm256_unpackhi_epi16(greenBlue, red);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute2x128_si256(low, high, 0x20));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 8u), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    // Remaining pixels
+    _blendRowSSE2(alpha + i, width - i, background, foreground, out + i);
+  }
+
+  // Selection of colors, 8 pixels by iteration, in a single register
+  __attribute__((target("avx2")))
+  static void _selectRowsAVX2(const uint8_t* const bits, const unsigned width, const unsigned height,
+                              const uint32_t background, const uint32_t foreground,
+                              uint32_t* const out)
+  {
+    const unsigned bytesPerRow = (width + 7u) / 8u;
+    const __m256i back = _mm256_set1_epi32(background);
+    const __m256i fore = _mm256_set1_epi32(foreground);
+    const __m256i bitValues = _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    for (unsigned j = 0u; j < height; ++j)
+    {
+      const uint8_t* const rowBits = bits + (j * bytesPerRow);
+      uint32_t* const rowOut = out + (j * width);
+      unsigned i = 0u;
+      for (; (i + 8u) <= width; i += 8u)
+      {
+        const __m256i byte = _mm256_set1_epi32(rowBits[i / 8u]);
+        const __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(byte, bitValues), bitValues);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rowOut + i), _mm256_blendv_epi8(back, fore, mask));
+      }
+      // Remaining pixels of the row
+      _selectPixelsScalar(rowBits, i, width, background, foreground, rowOut);
+    }
+  }
+#endif
+
+  ////
+  // Kernel selection
+  bool isKernelSupported(const Kernel kernel)
+  {
+    bool ret = false;
+    switch (kernel)
+    {
+#ifdef TERMINAL_BLEND_X86
+      case Kernel::SSE2:
+        __builtin_cpu_init();
+        ret = __builtin_cpu_supports("sse2");
+        break;
+      case Kernel::AVX2:
+        __builtin_cpu_init();
+        ret = __builtin_cpu_supports("avx2");
+        break;
+#endif
+      case Kernel::SCALAR:
+        ret = true;
+        break;
+      default:
+        ret = false;
+        break;
+    }
+    return ret;
+  }
+
+  static BlendRowFunction _getKernelFunction(const Kernel kernel)
+  {
+    BlendRowFunction ret = _blendRowScalar;
+    switch (kernel)
+    {
+#ifdef TERMINAL_BLEND_X86
+      case Kernel::SSE2:
+        ret = _blendRowSSE2;
+        break;
+      case Kernel::AVX2:
+        ret = _blendRowAVX2;
+        break;
+#endif
+      case Kernel::SCALAR:
+      default:
+        ret = _blendRowScalar;
+        break;
+    }
+    return ret;
+  }
+
+  static LerpRowFunction _getLerpFunction(const Kernel kernel)
+  {
+    LerpRowFunction ret = _lerpRowScalar;
+    switch (kernel)
+    {
+#ifdef TERMINAL_BLEND_X86
+      // There is no AVX2 version, the colors rows are short
+      case Kernel::SSE2:
+      case Kernel::AVX2:
+        ret = _lerpRowSSE2;
+        break;
+#endif
+      case Kernel::SCALAR:
+      default:
+        ret = _lerpRowScalar;
+        break;
+    }
+    return ret;
+  }
+
+  static SelectRowsFunction _getSelectFunction(const Kernel kernel)
+  {
+    SelectRowsFunction ret = _selectRowsScalar;
+    switch (kernel)
+    {
+#ifdef TERMINAL_BLEND_X86
+      case Kernel::SSE2:
+        ret = _selectRowsSSE2;
+        break;
+      case Kernel::AVX2:
+        ret = _selectRowsAVX2;
+        break;
+#endif
+      case Kernel::SCALAR:
+      default:
+        ret = _selectRowsScalar;
+        break;
+    }
+    return ret;
+  }
+
+  static Kernel _selectBestKernel(void)
+  {
+    Kernel ret = Kernel::SCALAR;
+    if (isKernelSupported(Kernel::AVX2))
+    {
+      ret = Kernel::AVX2;
+    }
+    else if (isKernelSupported(Kernel::SSE2))
+    {
+      ret = Kernel::SSE2;
+    }
+    return ret;
+  }
+
+  static Kernel s_kernel = _selectBestKernel();
+  static BlendRowFunction s_blendRow = _getKernelFunction(s_kernel);
+  static LerpRowFunction s_lerpRow = _getLerpFunction(s_kernel);
+  static SelectRowsFunction s_selectRows = _getSelectFunction(s_kernel);
+
+  Kernel getKernel(void)
+  {
+    return s_kernel;
+  }
+
+  bool setKernel(const Kernel kernel)
+  {
+    bool ret = isKernelSupported(kernel);
+    if (ret)
+    {
+      s_kernel = kernel;
+      s_blendRow = _getKernelFunction(kernel);
+      s_lerpRow = _getLerpFunction(kernel);
+      s_selectRows = _getSelectFunction(kernel);
+    }
+    return ret;
+  }
+
+  ////
+  // Blend a row of pixels
+  void blendRow(const uint8_t* const alpha, const unsigned width,
+                const Color& background, const Color& foreground,
+                uint32_t* const out)
+  {
+    s_blendRow(alpha, width, background, foreground, out);
+  }
+
+  ////
+  // Select the colors of a monochrome glyph
+  void selectRows(const uint8_t* const bits, const unsigned width, const unsigned height,
+                  const Color& background, const Color& foreground,
+                  uint32_t* const out)
+  {
+    s_selectRows(bits, width, height, background.toXRGB(), foreground.toXRGB(), out);
+  }
+
+  ////
+  // Interpolate rows of colors
+  void lerpRow(const uint32_t* const a, const uint32_t* const b, const uint16_t* const weights,
+               const unsigned width, uint32_t* const out)
+  {
+    s_lerpRow(a, b, weights, width, out);
+  }
+}
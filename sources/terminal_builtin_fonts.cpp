@@ -1,154 +1,215 @@
 #include "terminal_builtin_fonts.h"
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
 
-// The builtin fonts are stored as xbm or xpm(3) files in ressources/fonts.
+// The builtin fonts are stored as xbm files in ressources/fonts, listed by the font.inc files.
 // The xbm format describes a monochrome image as a static const array of char, in a C-source file format.
-// The xpm format describes a color image as various arrays, in a C-source file format.
-// Those files are included like any other C/C++ include files.
-// As a result, the data of those fonts are included in the produced binaries.
+// Those images are decoded at build time by tools/bake_fonts.cpp, which writes the glyphs as packed
+// monochrome images in ressources/fonts/baked_fonts.inc, in the format of the glyph atlas.
+// As a result, loading the builtin fonts is a copy of the images and a fill of the glyph tables,
+// done once per cell size: the root consoles of the same cell size share the builtin fonts.
 
-// Default font
 namespace LRTerminal
 {
-  namespace Fonts::Default
+  namespace Fonts
   {
-#include "fonts/default/font.inc"
-  }
-  namespace Fonts::TamsynR
-  {
-#include "fonts/TamsynR/font.inc"
-  }
-  namespace Fonts::TamsynB
-  {
-#include "fonts/TamsynB/font.inc"
-  }
-  namespace Fonts::SonyMisc8x16
-  {
-#include "fonts/8x16/font.inc"
-  }
-  namespace Fonts::MiscMisc8x13
-  {
-#include "fonts/8x13/font.inc"
-  }
-  namespace Fonts::MiscMisc8x13B
-  {
-#include "fonts/8x13B/font.inc"
+    // Glyphs of a builtin font in the baked glyphs
+    struct BakedFont
+    {
+      Font font;
+      unsigned firstGlyph;
+      unsigned glyphCount;
+    };
+    // Images of the baked glyphs at a cell size
+    struct BakedSize
+    {
+      unsigned glyphWidth;
+      unsigned glyphHeight;
+      const uint8_t* bits;
+    };
+#include "fonts/baked_fonts.inc"
+
+    // The baked glyphs are the builtin fonts at the default cell size, and their first baked size
+    static_assert((s_bakedGlyphWidth == C_GLYPH_WIDTH) && (s_bakedGlyphHeight == C_GLYPH_HEIGHT),
+                  "The glyphs of baked_fonts.inc are not of the size C_GLYPH_WIDTH x C_GLYPH_HEIGHT");
+    static_assert((s_bakedSizes[0].glyphWidth == C_GLYPH_WIDTH) && (s_bakedSizes[0].glyphHeight == C_GLYPH_HEIGHT),
+                  "The first baked size of baked_fonts.inc is not C_GLYPH_WIDTH x C_GLYPH_HEIGHT");
   }
-  namespace Fonts::MiscMisc8x13O
+
+  // Builtin fonts of a cell size
+  // The atlas and the resolved tables are built once, then only read, by all the root consoles of this size
+  struct BuiltinFonts::SharedFonts
   {
-#include "fonts/8x13O/font.inc"
-  }
-  namespace Fonts::Terminus
+    SharedFonts(const unsigned glyphWidth, const unsigned glyphHeight);
+
+    // Images of the glyphs of the builtin fonts
+    GlyphAtlas atlas;
+    // Map Font <-> FontData, without the custom font
+    std::map<Font, FontData> fonts;
+  };
+
+  BuiltinFonts::SharedFonts::SharedFonts(const unsigned glyphWidth, const unsigned glyphHeight):
+      atlas(glyphWidth, glyphHeight)
   {
-#include "fonts/Terminus/font.inc"
+    for (unsigned font = 0u; font < static_cast<unsigned>(Font::CUSTOM); ++font)
+    {
+      fonts.emplace(std::piecewise_construct,
+                    std::forward_as_tuple(static_cast<Font>(font)),
+                    std::forward_as_tuple(atlas));
+    }
+    // Images of the builtin glyphs, they are shared by the fonts which have the same glyphs
+    // They are baked at each cell size of the core option, the images are scaled here for the other sizes
+    const uint8_t* bits = NULL;
+    for (const Fonts::BakedSize& bakedSize : Fonts::s_bakedSizes)
+    {
+      if ((bakedSize.glyphWidth == glyphWidth) && (bakedSize.glyphHeight == glyphHeight))
+      {
+        bits = bakedSize.bits;
+      }
+    }
+    std::vector<uint8_t> scaledBits;
+    if (bits == NULL)
+    {
+      FontFile::scaleImages(Fonts::s_bakedGlyphBits, Fonts::s_bakedImageCount,
+                            Fonts::s_bakedGlyphWidth, Fonts::s_bakedGlyphHeight,
+                            glyphWidth, glyphHeight, scaledBits);
+      bits = scaledBits.data();
+    }
+    const unsigned firstGlyph = atlas.addMonochromeGlyphs(bits, Fonts::s_bakedImageCount);
+    // The tables of the fonts are resolved once all the fonts are set, as they fall back on the default font
+    FontData& defaultFont = fonts.at(Font::DEFAULT);
+    for (const Fonts::BakedFont& bakedFont : Fonts::s_bakedFonts)
+    {
+      FontData& fontData = fonts.at(bakedFont.font);
+      if (bakedFont.font != Font::DEFAULT)
+      {
+        fontData.setFallback(&defaultFont, false);
+      }
+      fontData.setGlyphs(Fonts::s_bakedCodePoints + bakedFont.firstGlyph,
+                         Fonts::s_bakedGlyphIndexes + bakedFont.firstGlyph,
+                         firstGlyph, bakedFont.glyphCount, false);
+    }
+    for (auto iter = fonts.begin(); iter != fonts.end(); ++iter)
+    {
+      iter->second.resolve();
+    }
+    // The fonts hold the references to the glyphs
+    for (unsigned i = 0u; i < Fonts::s_bakedImageCount; ++i)
+    {
+      atlas.removeGlyph(firstGlyph + i);
+    }
   }
-  namespace Fonts::TerminusBold
+
+  const BuiltinFonts::SharedFonts& BuiltinFonts::_getSharedFonts(const unsigned glyphWidth, const unsigned glyphHeight)
   {
-#include "fonts/TerminusBold/font.inc"
+    // The fonts of each size live until the end of the process
+    static std::mutex s_mutex;
+    static std::map<std::pair<unsigned, unsigned>, std::unique_ptr<SharedFonts> > s_sharedFonts;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    std::unique_ptr<SharedFonts>& sharedFonts = s_sharedFonts[std::make_pair(glyphWidth, glyphHeight)];
+    if (!sharedFonts)
+    {
+      sharedFonts.reset(new SharedFonts(glyphWidth, glyphHeight));
+    }
+    return *sharedFonts;
   }
 
   // Constuctor
-  BuiltinFonts::BuiltinFonts()
+  // Loading the builtin fonts is a lookup of the fonts of the cell size, only the first root console
+  // of a cell size copies the baked images and resolves the tables
+  BuiltinFonts::BuiltinFonts(const unsigned glyphWidth, const unsigned glyphHeight):
+      m_sharedFonts(_getSharedFonts(glyphWidth, glyphHeight)), m_customAtlas(glyphWidth, glyphHeight),
+      m_customFont(m_customAtlas)
   {
-    // Load the default font
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::DEFAULT),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::Default::load(*this);
-
-    // TamsynR
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::TAMSYN_REGULAR),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::TamsynR::load(*this);
-
-    // TamsynB
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::TAMSYN_BOLD),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::TamsynB::load(*this);
-
-    // 8x16
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::SONY_MISC_8x16),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::SonyMisc8x16::load(*this);
-
-    // 8x13
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::MISC_MISC_8x13),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::MiscMisc8x13::load(*this);
-
-    // 8x13B
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::MISC_MISC_8x13_BOLD),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::MiscMisc8x13B::load(*this);
-
-    // 8x13O
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::MISC_MISC_8x13_OBLIQUE),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::MiscMisc8x13O::load(*this);
-
-    // Terminus
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::TERMINUS),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::Terminus::load(*this);
-
-    // Terminus Bold
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::TERMINUS_BOLD),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
-    Fonts::TerminusBold::load(*this);
-
-    // Custom font, no glyph associated (outside the blank glyph)
-    m_fonts.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(Font::CUSTOM),
-                    std::forward_as_tuple(C_GLYPH_WIDTH,
-                                          C_GLYPH_HEIGHT));
+    for (unsigned font = 0u; font < C_FONT_COUNT; ++font)
+    {
+      m_fontTable[font] = (static_cast<Font>(font) == Font::CUSTOM) ? &m_customFont
+                                                                   : &m_sharedFonts.fonts.at(static_cast<Font>(font));
+    }
   }
 
   // Destructor
   BuiltinFonts::~BuiltinFonts()
   {
-    m_fonts.clear();
   }
 
   // Get a font
   const FontData& BuiltinFonts::getFontData(const Font font) const
   {
-    return m_fonts.at(font);
+    const unsigned index = static_cast<unsigned>(font);
+    return (index < C_FONT_COUNT) ? *m_fontTable[index] : *m_fontTable[0];
   }
 
-  const Glyph& BuiltinFonts::getGlyph(const Font font, const char32_t codePoint) const
+  const GlyphAtlas& BuiltinFonts::getAtlas(void) const
   {
-    const FontData& fontdata = getFontData(font);
-    if (fontdata.hasGlyph(codePoint))
+    return m_sharedFonts.atlas;
+  }
+
+  const GlyphAtlas& BuiltinFonts::getCustomAtlas(void) const
+  {
+    return m_customAtlas;
+  }
+
+  void BuiltinFonts::_addGlyphSheet(const char32_t startingCodePoint,
+                                    const unsigned width, const unsigned height, const uint8_t* const image,
+                                    const unsigned glyphWidth, const unsigned glyphHeight)
+  {
+    const unsigned cellWidth = m_customAtlas.getGlyphWidth();
+    const unsigned cellHeight = m_customAtlas.getGlyphHeight();
+    if ((glyphWidth == 0u) || (glyphHeight == 0u))
+    {
+      return;
+    }
+    if ((glyphWidth == cellWidth) && (glyphHeight == cellHeight))
     {
-      return fontdata.getGlyph(codePoint);
+      m_customFont.addGlyphs(startingCodePoint, image, width, height);
+      return;
     }
-    else
+    // Same layout of the glyphs in a sheet of the size of the cells, centered and cropped as BitmapFont::resize
+    const unsigned columns = width / glyphWidth;
+    const unsigned rows = height / glyphHeight;
+    const unsigned sheetWidth = columns * cellWidth;
+    const unsigned sheetHeight = rows * cellHeight;
+    std::vector<uint8_t> sheet(sheetWidth * sheetHeight, 0u);
+    // Offsets of the glyph in the cell, negative if the glyph is cropped
+    const int dx = (static_cast<int>(cellWidth) - static_cast<int>(glyphWidth)) / 2;
+    const int dy = (static_cast<int>(cellHeight) - static_cast<int>(glyphHeight)) / 2;
+    for (unsigned j = 0u; j < rows; ++j)
     {
-      return getFontData(Font::DEFAULT).getGlyph(codePoint);
+      for (unsigned i = 0u; i < columns; ++i)
+      {
+        for (unsigned y = 0u; y < glyphHeight; ++y)
+        {
+          const int cellY = static_cast<int>(y) + dy;
+          if ((cellY < 0) || (cellY >= static_cast<int>(cellHeight)))
+          {
+            continue;
+          }
+          const uint8_t* const src = &image[(((j * glyphHeight) + y) * width) + (i * glyphWidth)];
+          uint8_t* const dst = &sheet[(((j * cellHeight) + cellY) * sheetWidth) + (i * cellWidth)];
+          for (unsigned x = 0u; x < glyphWidth; ++x)
+          {
+            const int cellX = static_cast<int>(x) + dx;
+            if ((cellX >= 0) && (cellX < static_cast<int>(cellWidth)))
+            {
+              dst[cellX] = src[x];
+            }
+          }
+        }
+      }
     }
+    m_customFont.addGlyphs(startingCodePoint, sheet.data(), sheetWidth, sheetHeight);
   }
 
-  // Load an XBM image as part of a font variant
-  void BuiltinFonts::loadXbmFont(const Font font, const char32_t startingCodePoint,
-                                 const unsigned imageWidth, const unsigned imageHeight,
-                                 const unsigned char* const imageXbm)
+  // Load an XBM image as part of the custom font
+  void BuiltinFonts::addXBMToCustomFont(const char32_t startingCodePoint,
+                                        const unsigned imageWidth, const unsigned imageHeight,
+                                        const unsigned char* const imageXbm,
+                                        const unsigned glyphWidth, const unsigned glyphHeight)
   {
     // Decode the XBM image
     uint8_t* imageBuffer = new uint8_t[imageWidth * imageHeight];
@@ -184,22 +245,32 @@ namespace LRTerminal
       }
     }
     // Add the glyphs
-    m_fonts.at(font).addGlyphs(startingCodePoint, imageBuffer, imageWidth, imageHeight);
+    _addGlyphSheet(startingCodePoint, imageWidth, imageHeight, imageBuffer, glyphWidth, glyphHeight);
     delete[] imageBuffer;
   }
 
   void BuiltinFonts::addToCustomFont(const char32_t startingCodePoint,
                                      const unsigned width, const unsigned height,
-                                     const unsigned char* const image)
+                                     const unsigned char* const image,
+                                     const unsigned glyphWidth, const unsigned glyphHeight)
   {
-    m_fonts.at(Font::CUSTOM).addGlyphs(startingCodePoint, image, width, height);
+    _addGlyphSheet(startingCodePoint, width, height, image, glyphWidth, glyphHeight);
   }
 
-  void BuiltinFonts::addXBMToCustomFont(const char32_t startingCodePoint,
-                                        const unsigned width, const unsigned height,
-                                        const unsigned char* const image)
+  void BuiltinFonts::addToCustomFont(const FontFile::BitmapFont& font)
   {
-    loadXbmFont(Font::CUSTOM, startingCodePoint, width, height, image);
+    if ((font.glyphWidth != m_customAtlas.getGlyphWidth()) || (font.glyphHeight != m_customAtlas.getGlyphHeight()))
+    {
+      addToCustomFont(font.resize(m_customAtlas.getGlyphWidth(), m_customAtlas.getGlyphHeight()));
+      return;
+    }
+    // Same loading as the builtin fonts, the references of the images are held by the font
+    const unsigned firstGlyph = m_customAtlas.addMonochromeGlyphs(font.bits.data(), font.getImageCount());
+    m_customFont.setGlyphs(font.codePoints.data(), font.glyphs.data(), firstGlyph, font.codePoints.size());
+    for (unsigned i = 0u; i < font.getImageCount(); ++i)
+    {
+      m_customAtlas.removeGlyph(firstGlyph + i);
+    }
   }
 
 }
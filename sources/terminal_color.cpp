@@ -5,6 +5,34 @@
 
 namespace LRTerminal
 {
+  // Integer helpers for the component operations
+  // Division by 255, exact for 0 <= x <= 132853
+  static inline int _divideBy255(const int x)
+  {
+    return static_cast<int>((static_cast<uint64_t>(x) * 131587u) >> 25u);
+  }
+
+  // Reciprocals for the divisions by a component value: n / d == (n * s_reciprocals[d]) >> 24
+  // Exact for 0 <= n <= 255 * 255 and 0 < d <= 255
+  struct ReciprocalTable
+  {
+    constexpr ReciprocalTable(): values()
+    {
+      values[0] = 0u;
+      for (uint32_t d = 1u; d < 256u; ++d)
+      {
+        values[d] = ((1u << 24u) + d - 1u) / d;
+      }
+    }
+    uint32_t values[256];
+  };
+  static constexpr ReciprocalTable s_reciprocals;
+
+  static inline int _divideByComponent(const int n, const int d)
+  {
+    return static_cast<int>((static_cast<uint64_t>(n) * s_reciprocals.values[d]) >> 24u);
+  }
+
   // Constructors
   Color::Color(): m_R(0u), m_G(0u), m_B(0u)
   {
@@ -69,7 +97,7 @@ namespace LRTerminal
   // Operator *
   uint8_t _multiplyColorComponents(const uint8_t a, const uint8_t b)
   {
-    return static_cast<uint8_t>((static_cast<unsigned>(a) * static_cast<unsigned>(b)) / UINT8_MAX);
+    return static_cast<uint8_t>(_divideBy255(static_cast<int>(a) * static_cast<int>(b)));
   }
 
   Color Color::operator*(const Color& other) const
@@ -81,16 +109,23 @@ namespace LRTerminal
     return Color(R, G, B);
   }
 
-  uint8_t _scaleColorComponents(const uint8_t a, const float coeff)
+  // The scalar is used as a 8.8 fixed-point weight
+  uint8_t _scaleColorComponents(const uint8_t a, const int weight)
   {
-    return static_cast<uint8_t>(Utils::clamp(static_cast<int>(static_cast<float>(a) * coeff), 0, UINT8_MAX));
+    return static_cast<uint8_t>(std::min((static_cast<int>(a) * weight) >> 8, UINT8_MAX));
   }
 
   Color Color::operator*(const float scalar) const
   {
-    uint8_t R = _scaleColorComponents(m_R, scalar);
-    uint8_t G = _scaleColorComponents(m_G, scalar);
-    uint8_t B = _scaleColorComponents(m_B, scalar);
+    int weight = 0;
+    if (scalar > 0.0f)
+    {
+      // Scaling by more than 255 saturates all the non-zero components anyway
+      weight = static_cast<int>(std::min(scalar, 256.0f) * 256.0f + 0.5f);
+    }
+    uint8_t R = _scaleColorComponents(m_R, weight);
+    uint8_t G = _scaleColorComponents(m_G, weight);
+    uint8_t B = _scaleColorComponents(m_B, weight);
     //
     return Color(R, G, B);
   }
@@ -258,6 +293,13 @@ namespace LRTerminal
     return ((red << 16u) | (green << 8u) | blue);
   }
 
+  Color Color::fromXRGB(const uint32_t xrgb)
+  {
+    return Color(static_cast<uint8_t>(xrgb >> 16u),
+                 static_cast<uint8_t>(xrgb >> 8u),
+                 static_cast<uint8_t>(xrgb));
+  }
+
   // Setters
   void Color::setRed(uint8_t R)
   {
@@ -446,20 +488,58 @@ namespace LRTerminal
     setHSL(H, S * sscale, L * lscale);
   }
 
-  // Interpolation/Extrapolation in RGB
-  uint8_t _lerpColorComponents(const uint8_t a, const uint8_t b, float coeff)
+  // Interpolation/Extrapolation in RGB, with a 8.8 fixed-point weight
+  // a + (b - a) * weight / 256, rounded down
+  uint8_t _lerpColorComponents(const uint8_t a, const uint8_t b, const int weight)
   {
-    float ret = Utils::lerp(static_cast<float>(a), static_cast<float>(b), coeff);
-    return static_cast<uint8_t>(Utils::clamp(static_cast<int>(ret), 0, UINT8_MAX));
+    int ret = static_cast<int>(a) + (((static_cast<int>(b) - static_cast<int>(a)) * weight) >> 8);
+    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
   }
 
   Color Color::lerp(const Color& a, const Color& b, const float coeff)
   {
-    uint8_t R = _lerpColorComponents(a.m_R, b.m_R, coeff);
-    uint8_t G = _lerpColorComponents(a.m_G, b.m_G, coeff);
-    uint8_t B = _lerpColorComponents(a.m_B, b.m_B, coeff);
-    //
-    return Color(R, G, B);
+    Color ret;
+    if ((coeff >= 0.0f) && (coeff <= 1.0f))
+    {
+      ret = fromXRGB(lerpXRGB(a.toXRGB(), b.toXRGB(), toWeight(coeff)));
+    }
+    else
+    {
+      // Extrapolation, the components are clamped
+      const float limitedCoeff = Utils::clamp(coeff, -256.0f, 256.0f);
+      const int weight = static_cast<int>(std::floor(limitedCoeff * 256.0f + 0.5f));
+      ret.m_R = _lerpColorComponents(a.m_R, b.m_R, weight);
+      ret.m_G = _lerpColorComponents(a.m_G, b.m_G, weight);
+      ret.m_B = _lerpColorComponents(a.m_B, b.m_B, weight);
+    }
+    return ret;
+  }
+
+  Color Color::lerpFixed(const Color& a, const Color& b, const unsigned weight)
+  {
+    return fromXRGB(lerpXRGB(a.toXRGB(), b.toXRGB(), weight));
+  }
+
+  uint32_t Color::lerpXRGB(const uint32_t a, const uint32_t b, const unsigned weight)
+  {
+    // Red and blue are interpolated together, then green
+    // Each component has 16 bits of room, enough for (a * (256 - weight) + b * weight)
+    const uint32_t w = std::min(weight, 256u);
+    const uint32_t invW = 256u - w;
+    const uint32_t redBlue = ((((a & 0xFF00FFu) * invW) + ((b & 0xFF00FFu) * w)) >> 8u) & 0xFF00FFu;
+    const uint32_t green = ((((a & 0x00FF00u) * invW) + ((b & 0x00FF00u) * w)) >> 8u) & 0x00FF00u;
+    return redBlue | green;
+  }
+
+  unsigned Color::toWeight(const float coeff)
+  {
+    return static_cast<unsigned>(Utils::clamp(coeff, 0.0f, 1.0f) * 256.0f + 0.5f);
+  }
+
+  unsigned Color::alphaToWeight(const uint8_t alpha)
+  {
+    // 0x00 -> 0, 0x80 -> 129, 0xFF -> 256
+    return static_cast<unsigned>(alpha) + (static_cast<unsigned>(alpha) >> 7u);
   }
 
   // Lighten: max on each component
@@ -485,8 +565,8 @@ namespace LRTerminal
   // Screen: (1 - (1-a)*(1-b)) on each component
   uint8_t _screenColorComponents(const uint8_t a, const uint8_t b)
   {
-    int ret = 255 - (((255 - static_cast<int>(a)) * (255 - static_cast<int>(b))) / 255);
-    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
+    // Always in [0;255]
+    return static_cast<uint8_t>(255 - _divideBy255((255 - static_cast<int>(a)) * (255 - static_cast<int>(b))));
   }
 
   Color Color::screen(const Color& a, const Color& b)
@@ -504,9 +584,9 @@ namespace LRTerminal
     int ret = 255;
     if (a < 255)
     {
-      ret = (255 * static_cast<int>(b)) / (255 - static_cast<int>(a));
+      ret = std::min(_divideByComponent(255 * static_cast<int>(b), 255 - static_cast<int>(a)), 255);
     }
-    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
+    return static_cast<uint8_t>(ret);
   }
 
   Color Color::colorDodge(const Color& a, const Color& b)
@@ -524,9 +604,9 @@ namespace LRTerminal
     int ret = 0;
     if (b > 0)
     {
-      ret = 255 - ((255 * (255 - static_cast<int>(a))) / static_cast<int>(b));
+      ret = std::max(255 - _divideByComponent(255 * (255 - static_cast<int>(a)), static_cast<int>(b)), 0);
     }
-    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
+    return static_cast<uint8_t>(ret);
   }
 
   Color Color::colorBurn(const Color& a, const Color& b)
@@ -542,7 +622,7 @@ namespace LRTerminal
   uint8_t _burnColorComponents(const uint8_t a, const uint8_t b)
   {
     int ret = static_cast<int>(a) + static_cast<int>(b) - 255;
-    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
+    return static_cast<uint8_t>(std::max(ret, 0));
   }
 
   Color Color::burn(const Color& a, const Color& b)
@@ -560,13 +640,13 @@ namespace LRTerminal
     int ret = 0;
     if (b <= 128)
     {
-      ret = (2 * static_cast<int>(a) * static_cast<int>(b)) / 255;
+      ret = std::min(_divideBy255(2 * static_cast<int>(a) * static_cast<int>(b)), 255);
     }
     else
     {
-      ret = 255 - (2 * (255 - static_cast<int>(a)) * (255 - static_cast<int>(b))) / 255;
+      ret = 255 - _divideBy255(2 * (255 - static_cast<int>(a)) * (255 - static_cast<int>(b)));
     }
-    return static_cast<uint8_t>(Utils::clamp(ret, 0, UINT8_MAX));
+    return static_cast<uint8_t>(ret);
   }
 
   Color Color::overlay(const Color& a, const Color& b)
@@ -0,0 +1,355 @@
+#include "terminal_compositor.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace LRTerminal
+{
+  // Code point of the cells that have never been composited
+  static const char32_t C_INVALID_CODE_POINT(0xFFFFFFFFu);
+
+  ////
+  // Layer
+  Compositor::Layer::Layer(const unsigned width, const unsigned height, const int x, const int y):
+      Console(width, height), m_x(x), m_y(y),
+      m_foregroundAlpha(1.0f), m_backgroundAlpha(1.0f),
+      m_isVisible(true), m_isComposed(false), m_composedState()
+  {
+    const ComposedCell invalidCell = { C_INVALID_CODE_POINT, 0u, 0u, 0u };
+    m_composedCells.assign(width * height, invalidCell);
+  }
+
+  Compositor::Layer::~Layer()
+  {
+  }
+
+  void Compositor::Layer::setPosition(const int x, const int y)
+  {
+    m_x = x;
+    m_y = y;
+  }
+
+  int Compositor::Layer::getX(void) const
+  {
+    return m_x;
+  }
+
+  int Compositor::Layer::getY(void) const
+  {
+    return m_y;
+  }
+
+  void Compositor::Layer::setAlpha(const float foregroundAlpha, const float backgroundAlpha)
+  {
+    m_foregroundAlpha = foregroundAlpha;
+    m_backgroundAlpha = backgroundAlpha;
+  }
+
+  float Compositor::Layer::getForegroundAlpha(void) const
+  {
+    return m_foregroundAlpha;
+  }
+
+  float Compositor::Layer::getBackgroundAlpha(void) const
+  {
+    return m_backgroundAlpha;
+  }
+
+  void Compositor::Layer::setVisible(const bool isVisible)
+  {
+    m_isVisible = isVisible;
+  }
+
+  bool Compositor::Layer::isVisible(void) const
+  {
+    return m_isVisible;
+  }
+
+  void Compositor::Layer::_onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                                    const int dx, const int dy)
+  {
+    (void) dx;
+    (void) dy;
+    DirtyTracker& dirtyCells = _getDirtyCells();
+    for (unsigned y = y0; y < y1; ++y)
+    {
+      for (unsigned x = x0; x < x1; ++x)
+      {
+        dirtyCells.mark(x, y);
+      }
+    }
+  }
+
+  bool Compositor::Layer::ComposedState::operator==(const ComposedState& that) const
+  {
+    return (x == that.x) && (y == that.y)
+        && (foregroundAlpha == that.foregroundAlpha) && (backgroundAlpha == that.backgroundAlpha)
+        && (isVisible == that.isVisible)
+        && (isIgnoreCellColorEnabled == that.isIgnoreCellColorEnabled)
+        && (ignoreCellColor == that.ignoreCellColor);
+  }
+
+  Compositor::Layer::ComposedState Compositor::Layer::_getState(void) const
+  {
+    ComposedState ret;
+    ret.x = m_x;
+    ret.y = m_y;
+    ret.foregroundAlpha = m_foregroundAlpha;
+    ret.backgroundAlpha = m_backgroundAlpha;
+    ret.isVisible = m_isVisible;
+    ret.isIgnoreCellColorEnabled = isIgnoreCellColorEnabled();
+    ret.ignoreCellColor = getIgnoreCellColor().toXRGB();
+    return ret;
+  }
+
+  template <typename Function>
+  void Compositor::Layer::_collectChangedCells(Function onChanged)
+  {
+    DirtyTracker& dirtyCells = _getDirtyCells();
+    const unsigned layerWidth = getWidth();
+    // The dirty cells are enumerated row by row
+    unsigned row = getHeight();
+    CellSpan cells = { NULL, NULL, NULL, NULL };
+    dirtyCells.forEachDirtyCell(0u, getHeight(), [&](const unsigned x, const unsigned y) {
+      if (y != row)
+      {
+        row = y;
+        cells = _getRowCells(row);
+      }
+      ComposedCell& composed = m_composedCells[(y * layerWidth) + x];
+      if ((composed.codePoint == cells.codePoints[x]) && (composed.font == cells.fonts[x]) &&
+          (composed.foreground == cells.foregrounds[x]) && (composed.background == cells.backgrounds[x]))
+      {
+        return;
+      }
+      composed.codePoint = cells.codePoints[x];
+      composed.font = cells.fonts[x];
+      composed.foreground = cells.foregrounds[x];
+      composed.background = cells.backgrounds[x];
+      onChanged(x, y);
+    });
+    dirtyCells.clearRows(0u, getHeight());
+    dirtyCells.clearRowSummary();
+  }
+
+  // A cell hides the layers below if it is blitted with full opacity and is not blank,
+  // as blitting a blank cell keeps the code point of the destination
+  // The coordinates are in the target console
+  bool Compositor::Layer::_isOpaqueAt(const int x, const int y) const
+  {
+    const int xLayer = x - m_x;
+    const int yLayer = y - m_y;
+    return m_isVisible && (m_foregroundAlpha == 1.0f) && (m_backgroundAlpha == 1.0f)
+        && (xLayer >= 0) && (xLayer < static_cast<int>(getWidth()))
+        && (yLayer >= 0) && (yLayer < static_cast<int>(getHeight()))
+        && !_isBlank(getChar(xLayer, yLayer))
+        && (!isIgnoreCellColorEnabled() || (getBackground(xLayer, yLayer) != getIgnoreCellColor()));
+  }
+
+  ////
+  // Compositor
+  // Constructor, destructor
+  Compositor::Compositor(const unsigned width, const unsigned height):
+      m_width(width), m_height(height), m_damage(width, height)
+  {
+  }
+
+  Compositor::~Compositor()
+  {
+    for (auto iter = m_layers.begin(); iter != m_layers.end(); ++iter)
+    {
+      delete *iter;
+    }
+    m_layers.clear();
+  }
+
+  // Layers handling
+  Compositor::Layer& Compositor::addLayer(const unsigned width, const unsigned height, const int x, const int y)
+  {
+    Layer* layer = new Layer(width, height, x, y);
+    m_layers.push_back(layer);
+    return *layer;
+  }
+
+  void Compositor::removeLayer(Layer& layer)
+  {
+    const unsigned index = _findLayer(layer);
+    // The cells where the layer was have to be composited again
+    if (layer.m_isComposed)
+    {
+      _damageArea(layer, layer.m_composedState);
+    }
+    m_layers.erase(m_layers.begin() + index);
+    delete &layer;
+  }
+
+  void Compositor::setLayerIndex(Layer& layer, const unsigned index)
+  {
+    const unsigned currentIndex = _findLayer(layer);
+    const unsigned newIndex = std::min(index, getLayerCount() - 1u);
+    if (currentIndex != newIndex)
+    {
+      m_layers.erase(m_layers.begin() + currentIndex);
+      m_layers.insert(m_layers.begin() + newIndex, &layer);
+      // The order of the layers changes the result where the layer is
+      if (layer.m_isComposed)
+      {
+        _damageArea(layer, layer.m_composedState);
+      }
+    }
+  }
+
+  unsigned Compositor::getLayerCount(void) const
+  {
+    return m_layers.size();
+  }
+
+  Compositor::Layer& Compositor::getLayer(const unsigned index)
+  {
+    return *m_layers.at(index);
+  }
+
+  unsigned Compositor::_findLayer(const Layer& layer) const
+  {
+    auto found = std::find(m_layers.begin(), m_layers.end(), &layer);
+    if (found == m_layers.end())
+    {
+      throw std::invalid_argument("The layer does not belong to this compositor");
+    }
+    return found - m_layers.begin();
+  }
+
+  // Mark the cells covered by a layer
+  void Compositor::_damageArea(const Layer& layer, const Layer::ComposedState& state)
+  {
+    if (state.isVisible)
+    {
+      const int xStart = std::max(state.x, 0);
+      const int yStart = std::max(state.y, 0);
+      const int xEnd = std::min(state.x + static_cast<int>(layer.getWidth()), static_cast<int>(m_width));
+      const int yEnd = std::min(state.y + static_cast<int>(layer.getHeight()), static_cast<int>(m_height));
+      for (int y = yStart; y < yEnd; ++y)
+      {
+        for (int x = xStart; x < xEnd; ++x)
+        {
+          m_damage.mark(x, y);
+        }
+      }
+    }
+  }
+
+  void Compositor::invalidate(void)
+  {
+    m_damage.markAll();
+  }
+
+  // Gather the changes of the layers
+  void Compositor::_collectDamage(void)
+  {
+    for (auto iter = m_layers.begin(); iter != m_layers.end(); ++iter)
+    {
+      Layer& layer = **iter;
+      const Layer::ComposedState state = layer._getState();
+      if (!layer.m_isComposed || !(state == layer.m_composedState))
+      {
+        // Moved, shown, hidden or new: both the old and new areas are composited
+        if (layer.m_isComposed)
+        {
+          _damageArea(layer, layer.m_composedState);
+        }
+        _damageArea(layer, state);
+        layer._collectChangedCells([](const unsigned, const unsigned) {});
+      }
+      else
+      {
+        // Only the modified cells
+        layer._collectChangedCells([this, &state](const unsigned x, const unsigned y) {
+          const int xTarget = state.x + static_cast<int>(x);
+          const int yTarget = state.y + static_cast<int>(y);
+          if ( state.isVisible
+            && (xTarget >= 0) && (xTarget < static_cast<int>(m_width))
+            && (yTarget >= 0) && (yTarget < static_cast<int>(m_height)))
+          {
+            m_damage.mark(xTarget, yTarget);
+          }
+        });
+      }
+      layer.m_composedState = state;
+      layer.m_isComposed = true;
+    }
+  }
+
+  // Only the layers from the top to the first opaque cell are visible
+  unsigned Compositor::_findFirstVisibleLayer(const int x, const int y) const
+  {
+    unsigned ret = 0u;
+    for (unsigned i = m_layers.size(); i > 0u; --i)
+    {
+      if (m_layers[i - 1u]->_isOpaqueAt(x, y))
+      {
+        ret = i - 1u;
+        break;
+      }
+    }
+    return ret;
+  }
+
+  // Composite a run of cells of a row
+  void Compositor::_composeRun(Console& target, const TextStyle& baseStyle,
+                               const int x, const int y, const unsigned count, const unsigned firstLayer)
+  {
+    // The run starts from the cleared target, so the result does not depend on the previous content
+    target.rect(x, y, count, 1u, true, baseStyle);
+    for (unsigned i = firstLayer; i < m_layers.size(); ++i)
+    {
+      const Layer& layer = *m_layers[i];
+      if (layer.isVisible())
+      {
+        Console::blit(layer, x - layer.getX(), y - layer.getY(), count, 1,
+                      target, x, y, layer.getForegroundAlpha(), layer.getBackgroundAlpha());
+      }
+    }
+  }
+
+  // Composite the changed cells into the target console
+  void Compositor::compose(Console& target)
+  {
+    _collectDamage();
+    if (m_damage.isEmpty())
+    {
+      return;
+    }
+    TextStyle baseStyle = target.getDefaultStyle();
+    baseStyle.setBackgroundFlag(BackgroundFlag::SET);
+    // The damaged cells are grouped into runs of consecutive cells starting at the same layer
+    int runX = 0;
+    int runY = -1;
+    unsigned runCount = 0u;
+    unsigned runLayer = 0u;
+    m_damage.forEachDirtyCell(0u, m_height, [&](const unsigned x, const unsigned y) {
+      const unsigned firstLayer = _findFirstVisibleLayer(x, y);
+      if ( (static_cast<int>(y) == runY) && (static_cast<int>(x) == runX + static_cast<int>(runCount))
+        && (firstLayer == runLayer))
+      {
+        ++runCount;
+      }
+      else
+      {
+        if (runCount > 0u)
+        {
+          _composeRun(target, baseStyle, runX, runY, runCount, runLayer);
+        }
+        runX = x;
+        runY = y;
+        runCount = 1u;
+        runLayer = firstLayer;
+      }
+    });
+    if (runCount > 0u)
+    {
+      _composeRun(target, baseStyle, runX, runY, runCount, runLayer);
+    }
+    m_damage.clearRows(0u, m_height);
+    m_damage.clearRowSummary();
+  }
+
+}
@@ -1,127 +1,165 @@
 #include "terminal_console.h"
-#include <locale>
-#include <codecvt>
+#include "terminal_utils.h"
+#include "terminal_blend.h"
+#include "terminal_utf8.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 
 namespace LRTerminal
 {
+  // The cells are stored in chunks of 2^C_CHUNK_ROW_SHIFT rows
+  static const unsigned C_CHUNK_ROW_SHIFT(3u);
+  static const unsigned C_CHUNK_ROWS(1u << C_CHUNK_ROW_SHIFT);
 
   ////
-  // Console cell
-  Console::ConsoleCell::ConsoleCell():
-      m_background(0u, 0u, 0u), m_foreground(0u, 0u, 0u),
-      m_codePoint(0u), m_font(Font::DEFAULT),
-      m_isDirty(true)
+  // Cell helpers
+  // A cell is considered blank if the code point corresponds to Nul or Space
+  bool Console::_isBlank(const char32_t codePoint)
   {
+    return (codePoint == U'\0') || (codePoint == U' ');
   }
 
-  const Color& Console::ConsoleCell::getBackground(void) const
+  // Apply a background flag to the current background of a cell
+  Color Console::_blendBackground(const Color& current, const Color& color, const BackgroundFlag flag)
   {
-    return m_background;
-  }
-
-  const Color& Console::ConsoleCell::getForeground(void) const
-  {
-    return m_foreground;
-  }
-
-  char32_t Console::ConsoleCell::getCodePoint(void) const
-  {
-    return m_codePoint;
-  }
-
-  Font Console::ConsoleCell::getFont(void) const
-  {
-    return m_font;
-  }
-
-  bool Console::ConsoleCell::isDirty(void) const
-  {
-    return m_isDirty;
-  }
-
-  bool Console::ConsoleCell::isBlank(void) const
-  {
-    // A cell is considered blank if the code point corresponds to Nul or Space
-    return (m_codePoint == U'\0') || (m_codePoint == U' ');
-  }
-
-  void Console::ConsoleCell::setForeground(const Color& color)
-  {
-    if (m_foreground != color)
-    {
-      m_foreground = color;
-      m_isDirty = true;
-    }
-  }
-
-  void Console::ConsoleCell::setBackground(const Color& color, const BackgroundFlag flag)
-  {
-    Color newColor;
+    Color ret;
     switch (flag)
     {
       case BackgroundFlag::SET:
-        newColor = color;
+        ret = color;
         break;
       case BackgroundFlag::MULTIPLY:
-        newColor = m_background * color;
+        ret = current * color;
         break;
       case BackgroundFlag::LIGHTEN:
-        newColor = Color::lighten(m_background, color);
+        ret = Color::lighten(current, color);
         break;
       case BackgroundFlag::DARKEN:
-        newColor = Color::darken(m_background, color);
+        ret = Color::darken(current, color);
         break;
       case BackgroundFlag::SCREEN:
-        newColor = Color::screen(m_background, color);
+        ret = Color::screen(current, color);
         break;
       case BackgroundFlag::COLOR_DODGE:
-        newColor = Color::colorDodge(m_background, color);
+        ret = Color::colorDodge(current, color);
         break;
       case BackgroundFlag::COLOR_BURN:
-        newColor = Color::colorBurn(m_background, color);
+        ret = Color::colorBurn(current, color);
         break;
       case BackgroundFlag::ADD:
-        newColor = m_background + color;
+        ret = current + color;
         break;
       case BackgroundFlag::BURN:
-        newColor = Color::burn(m_background, color);
+        ret = Color::burn(current, color);
         break;
       case BackgroundFlag::OVERLAY:
-        newColor = Color::overlay(m_background, color);
+        ret = Color::overlay(current, color);
         break;
       case BackgroundFlag::NONE:
       default:
-        newColor = m_background;
+        ret = current;
         break;
     }
-    if (m_background != newColor)
+    return ret;
+  }
+
+  // Background of a cell after applying a color with a background flag, as XRGB
+  uint32_t Console::_computeBackground(const uint32_t current, const Color& color, const BackgroundFlag flag)
+  {
+    uint32_t ret = 0u;
+    if (flag == BackgroundFlag::SET)
+    {
+      ret = color.toXRGB();
+    }
+    else
     {
-      m_background = newColor;
-      m_isDirty = true;
+      ret = _blendBackground(Color::fromXRGB(current), color, flag).toXRGB();
     }
+    return ret;
   }
 
-  void Console::ConsoleCell::setCodePoint(const char32_t codePoint)
+  // Prepare a row for writing into it
+  Console::CellChunk& Console::_resolveRow(const unsigned y)
   {
-    if (m_codePoint != codePoint)
+    std::shared_ptr<CellChunk>& chunk = m_chunks[y >> C_CHUNK_ROW_SHIFT];
+    // The chunk is shared with a copy of the console, the copy keeps the original
+    if (chunk.use_count() > 1)
+    {
+      chunk = std::make_shared<CellChunk>(*chunk);
+    }
+    // Apply the pending clear
+    if (_isRowCleared(y))
     {
-      m_codePoint = codePoint;
-      m_isDirty = true;
+      const unsigned first = _getRowIndex(y);
+      std::copy(m_clearedRow->codePoints.begin(), m_clearedRow->codePoints.end(), chunk->codePoints.begin() + first);
+      std::copy(m_clearedRow->foregrounds.begin(), m_clearedRow->foregrounds.end(), chunk->foregrounds.begin() + first);
+      std::copy(m_clearedRow->backgrounds.begin(), m_clearedRow->backgrounds.end(), chunk->backgrounds.begin() + first);
+      std::copy(m_clearedRow->fonts.begin(), m_clearedRow->fonts.end(), chunk->fonts.begin() + first);
+      m_rowGenerations[y] = m_clearGeneration;
     }
+    return *chunk;
+  }
+
+  bool Console::_isRowCleared(const unsigned y) const
+  {
+    return m_rowGenerations[y] != m_clearGeneration;
+  }
+
+  // Content of a cell, taking into account a pending clear of its row
+  char32_t Console::_getCodePointAt(const unsigned x, const unsigned y) const
+  {
+    return _isRowCleared(y) ? 0u : _getChunk(y).codePoints[_cellIndex(x, y)];
+  }
+
+  uint32_t Console::_getForegroundAt(const unsigned x, const unsigned y) const
+  {
+    return _isRowCleared(y) ? m_clearForeground : _getChunk(y).foregrounds[_cellIndex(x, y)];
+  }
+
+  uint32_t Console::_getBackgroundAt(const unsigned x, const unsigned y) const
+  {
+    return _isRowCleared(y) ? m_clearBackground : _getChunk(y).backgrounds[_cellIndex(x, y)];
   }
 
-  void Console::ConsoleCell::setFont(const Font font)
+  uint8_t Console::_getFontAt(const unsigned x, const unsigned y) const
   {
-    if (m_font != font)
+    return _isRowCleared(y) ? m_clearFont : _getChunk(y).fonts[_cellIndex(x, y)];
+  }
+
+  // Set all the properties of a cell, which is marked dirty if it has changed
+  void Console::_setCell(const unsigned x, const unsigned y, const char32_t codePoint,
+                         const uint32_t foreground, const uint32_t background, const uint8_t font)
+  {
+    CellChunk& chunk = _resolveRow(y);
+    const unsigned index = _cellIndex(x, y);
+    if ( (chunk.codePoints[index] != codePoint) || (chunk.foregrounds[index] != foreground)
+      || (chunk.backgrounds[index] != background) || (chunk.fonts[index] != font))
     {
-      m_font = font;
-      m_isDirty = true;
+      chunk.codePoints[index] = codePoint;
+      chunk.foregrounds[index] = foreground;
+      chunk.backgrounds[index] = background;
+      chunk.fonts[index] = font;
+      m_dirtyCells.mark(x, y);
     }
   }
 
-  void Console::ConsoleCell::unsetDirty(void)
+  // Set all the properties of a run of cells of a row, in drawing coordinates
+  void Console::_setCells(const int x, const int y, const unsigned count, const CellSpan& cells)
   {
-    m_isDirty = false;
+    const int xFirst = x + m_viewport.x;
+    const int yCell = y + m_viewport.y;
+    if ((yCell >= m_viewport.yMin) && (yCell < m_viewport.yMax))
+    {
+      // Only the part of the run inside the viewport is written
+      const int xStart = std::max(xFirst, m_viewport.xMin);
+      const int xEnd = std::min(xFirst + static_cast<int>(count), m_viewport.xMax);
+      for (int i = xStart; i < xEnd; ++i)
+      {
+        const unsigned j = i - xFirst;
+        _setCell(i, yCell, cells.codePoints[j], cells.foregrounds[j], cells.backgrounds[j], cells.fonts[j]);
+      }
+    }
   }
 
   ////
@@ -129,14 +167,72 @@ namespace LRTerminal
   // Constructor, destructor
   Console::Console(const unsigned width, const unsigned height):
       m_width(width), m_height(height), m_defaultStyle(),
-      m_isIgnoreCellColorEnabled(false), m_ignoreCellColor()
-  {
-    m_cells.resize(m_width * m_height);
+      m_isIgnoreCellColorEnabled(false), m_ignoreCellColor(),
+      m_dirtyCells(width, height),
+      m_viewport({0, 0, 0, 0, static_cast<int>(width), static_cast<int>(height)}), m_clearGeneration(0u),
+      m_clearForeground(0u), m_clearBackground(0u), m_clearFont(static_cast<uint8_t>(Font::DEFAULT))
+  {
+    m_clearedRow = std::make_shared<CellChunk>();
+    m_clearedRow->codePoints.assign(m_width, 0u);
+    m_clearedRow->foregrounds.assign(m_width, m_clearForeground);
+    m_clearedRow->backgrounds.assign(m_width, m_clearBackground);
+    m_clearedRow->fonts.assign(m_width, m_clearFont);
+    for (unsigned y = 0u; y < m_height; y += C_CHUNK_ROWS)
+    {
+      const unsigned cellCount = m_width * std::min(C_CHUNK_ROWS, m_height - y);
+      std::shared_ptr<CellChunk> chunk = std::make_shared<CellChunk>();
+      chunk->codePoints.assign(cellCount, 0u);
+      chunk->foregrounds.assign(cellCount, m_clearForeground);
+      chunk->backgrounds.assign(cellCount, m_clearBackground);
+      chunk->fonts.assign(cellCount, m_clearFont);
+      m_chunks.push_back(chunk);
+    }
+    m_rowGenerations.assign(m_height, m_clearGeneration);
   }
 
   Console::~Console()
   {
-    m_cells.clear();
+  }
+
+  // Copy, only the pointers to the chunks and the cleared row are copied
+  Console::Console(const Console& that):
+      m_chunks(that.m_chunks), m_width(that.m_width), m_height(that.m_height), m_defaultStyle(that.m_defaultStyle),
+      m_isIgnoreCellColorEnabled(that.m_isIgnoreCellColorEnabled), m_ignoreCellColor(that.m_ignoreCellColor),
+      m_dirtyCells(that.m_width, that.m_height),
+      m_viewport({0, 0, 0, 0, static_cast<int>(that.m_width), static_cast<int>(that.m_height)}),
+      m_clearGeneration(that.m_clearGeneration), m_rowGenerations(that.m_rowGenerations),
+      m_clearForeground(that.m_clearForeground), m_clearBackground(that.m_clearBackground),
+      m_clearFont(that.m_clearFont), m_clearedRow(that.m_clearedRow)
+  {
+  }
+
+  Console& Console::operator=(const Console& that)
+  {
+    if (this != &that)
+    {
+      m_chunks = that.m_chunks;
+      if ((m_width != that.m_width) || (m_height != that.m_height))
+      {
+        m_width = that.m_width;
+        m_height = that.m_height;
+        m_dirtyCells = DirtyTracker(m_width, m_height);
+      }
+      else
+      {
+        m_dirtyCells.markAll();
+      }
+      m_defaultStyle = that.m_defaultStyle;
+      m_isIgnoreCellColorEnabled = that.m_isIgnoreCellColorEnabled;
+      m_ignoreCellColor = that.m_ignoreCellColor;
+      m_viewport = {0, 0, 0, 0, static_cast<int>(m_width), static_cast<int>(m_height)};
+      m_clearGeneration = that.m_clearGeneration;
+      m_rowGenerations = that.m_rowGenerations;
+      m_clearForeground = that.m_clearForeground;
+      m_clearBackground = that.m_clearBackground;
+      m_clearFont = that.m_clearFont;
+      m_clearedRow = that.m_clearedRow;
+    }
+    return *this;
   }
 
   // Default Style
@@ -173,129 +269,169 @@ namespace LRTerminal
   // Clear the console: set all characters to nul and the colors to the default colors
   void Console::clear(void)
   {
-    for (auto iter = m_cells.begin(); iter != m_cells.end(); ++iter)
+    // The cells are not modified here: all the rows are considered cleared until they are written,
+    // and reading a cleared row gives the values below
+    m_clearForeground = m_defaultStyle.getForeground().toXRGB();
+    m_clearBackground = m_defaultStyle.getBackground().toXRGB();
+    m_clearFont = static_cast<uint8_t>(m_defaultStyle.getFont());
+    // The cleared row is duplicated if a copy of the console shares it
+    if (m_clearedRow.use_count() > 1)
     {
-      iter->setCodePoint(0u);
-      iter->setForeground(m_defaultStyle.getForeground());
-      iter->setBackground(m_defaultStyle.getBackground());
-      iter->setFont(m_defaultStyle.getFont());
+      m_clearedRow = std::make_shared<CellChunk>(*m_clearedRow);
     }
+    std::fill(m_clearedRow->foregrounds.begin(), m_clearedRow->foregrounds.end(), m_clearForeground);
+    std::fill(m_clearedRow->backgrounds.begin(), m_clearedRow->backgrounds.end(), m_clearBackground);
+    std::fill(m_clearedRow->fonts.begin(), m_clearedRow->fonts.end(), m_clearFont);
+    ++m_clearGeneration;
+    // The renderer compares the cells with what is on screen, so marking all the cells costs little
+    m_dirtyCells.markAll();
   }
 
   // Set the codepoint of a cell
   void Console::setChar(const int x, const int y, const char32_t c)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      m_cells[_cellIndex(x, y)].setCodePoint(c);
+      CellChunk& chunk = _resolveRow(yCell);
+      const unsigned index = _cellIndex(xCell, yCell);
+      if (chunk.codePoints[index] != c)
+      {
+        chunk.codePoints[index] = c;
+        m_dirtyCells.mark(xCell, yCell);
+      }
     }
   }
   // Set all the properties of a cell
   void Console::setChar(const int x, const int y, const char32_t c, const TextStyle& style)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      m_cells[_cellIndex(x, y)].setCodePoint(c);
-      m_cells[_cellIndex(x, y)].setForeground(style.getForeground());
-      m_cells[_cellIndex(x, y)].setBackground(style.getBackground(), style.getBackgroundFlag());
-      m_cells[_cellIndex(x, y)].setFont(style.getFont());
+      const CellChunk& chunk = _resolveRow(yCell);
+      _setCell(xCell, yCell, c, style.getForeground().toXRGB(),
+               _computeBackground(chunk.backgrounds[_cellIndex(xCell, yCell)], style.getBackground(), style.getBackgroundFlag()),
+               static_cast<uint8_t>(style.getFont()));
     }
   }
   // Set the style of a char
   void Console::setStyle(const int x, const int y, const TextStyle& style)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      setChar(x, y, getChar(x, y), style);
+      const CellChunk& chunk = _resolveRow(yCell);
+      const unsigned index = _cellIndex(xCell, yCell);
+      _setCell(xCell, yCell, chunk.codePoints[index], style.getForeground().toXRGB(),
+               _computeBackground(chunk.backgrounds[index], style.getBackground(), style.getBackgroundFlag()),
+               static_cast<uint8_t>(style.getFont()));
     }
   }
   // Set the background color of a cell
   void Console::setBackground(const int x, const int y, const Color& col,
                               const BackgroundFlag flag)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      m_cells[_cellIndex(x, y)].setBackground(col, flag);
+      CellChunk& chunk = _resolveRow(yCell);
+      const unsigned index = _cellIndex(xCell, yCell);
+      const uint32_t background = _computeBackground(chunk.backgrounds[index], col, flag);
+      if (chunk.backgrounds[index] != background)
+      {
+        chunk.backgrounds[index] = background;
+        m_dirtyCells.mark(xCell, yCell);
+      }
     }
   }
   // Set the foreground color of a cell
   void Console::setForeground(const int x, const int y, const Color& col)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      m_cells[_cellIndex(x, y)].setForeground(col);
+      CellChunk& chunk = _resolveRow(yCell);
+      const unsigned index = _cellIndex(xCell, yCell);
+      const uint32_t foreground = col.toXRGB();
+      if (chunk.foregrounds[index] != foreground)
+      {
+        chunk.foregrounds[index] = foreground;
+        m_dirtyCells.mark(xCell, yCell);
+      }
     }
   }
   // Set the font of a cell
   void Console::setFont(const int x, const int y, const Font font)
   {
-    if (_isInside(x, y))
+    int xCell = 0;
+    int yCell = 0;
+    if (_mapCell(x, y, xCell, yCell))
     {
-      m_cells[_cellIndex(x, y)].setFont(font);
+      CellChunk& chunk = _resolveRow(yCell);
+      const unsigned index = _cellIndex(xCell, yCell);
+      if (chunk.fonts[index] != static_cast<uint8_t>(font))
+      {
+        chunk.fonts[index] = static_cast<uint8_t>(font);
+        m_dirtyCells.mark(xCell, yCell);
+      }
     }
   }
 
   // Print a formatted string with default style
   void Console::print(const int x, const int y, const char* fmt, ...)
   {
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    std::string str = _computeString(size, fmt, args);
+    const std::string_view str = _formatText(buffer, fmt, args);
     va_end(args);
-    print(x, y, m_defaultStyle, _stringToU32String(str));
+    print(x, y, m_defaultStyle, str);
   }
   // Print an utf-8 string with default style
-  void Console::print(const int x, const int y, const std::string& str)
+  void Console::print(const int x, const int y, const std::string_view str)
   {
-    print(x, y, m_defaultStyle, _stringToU32String(str));
+    print(x, y, m_defaultStyle, str);
   }
   // Print an utf-32 string with default style
-  void Console::print(const int x, const int y, const std::u32string& str)
+  void Console::print(const int x, const int y, const std::u32string_view str)
   {
     print(x, y, m_defaultStyle, str);
   }
   // Print a formatted string, with specific style
   void Console::print(const int x, const int y, const TextStyle& style, const char* fmt, ...)
   {
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    std::string str = _computeString(size, fmt, args);
+    const std::string_view str = _formatText(buffer, fmt, args);
     va_end(args);
-    print(x, y, style, _stringToU32String(str));
+    print(x, y, style, str);
   }
   // Print an utf-8 string, with specific style
-  void Console::print(const int x, const int y, const TextStyle& style, const std::string& str)
+  void Console::print(const int x, const int y, const TextStyle& style, const std::string_view str)
   {
-    if (str.size() > 0)
+    // The code points are decoded directly into the cells
+    const unsigned length = Utf8::getLength(str.data(), str.size());
+    if (length > 0u)
     {
-      print(x, y, style, _stringToU32String(str));
+      int xPos = _computeStartPosition(x, length, style.getAlignment());
+      Utf8::forEachCodePoint(str.data(), str.size(), [this, &xPos, y, &style](const char32_t codePoint) {
+        setChar(xPos, y, codePoint, style);
+        ++xPos;
+      });
     }
   }
   // Print an utf-32 string, with specific style
-  void Console::print(const int x, const int y, const TextStyle& style, const std::u32string& str)
+  void Console::print(const int x, const int y, const TextStyle& style, const std::u32string_view str)
   {
     if (str.size() > 0)
     {
-      int xStartPos = 0;
-      Alignment align = style.getAlignment();
-      if (align == Alignment::CENTER)
-      {
-        xStartPos = x - (str.size() / 2);
-      }
-      else if (align == Alignment::RIGHT)
-      {
-        xStartPos = x - str.size() + 1;
-      }
-      else
-      {
-        xStartPos = x;
-      }
+      const int xStartPos = _computeStartPosition(x, str.size(), style.getAlignment());
       for (unsigned i = 0u; i < str.size(); ++i)
       {
         setChar(xStartPos + i, y, str.at(i), style);
@@ -307,26 +443,24 @@ namespace LRTerminal
                           const unsigned w, const unsigned h,
                           const bool clearText, const char* fmt, ...)
   {
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    std::string str = _computeString(size, fmt, args);
+    const std::string_view str = _formatText(buffer, fmt, args);
     va_end(args);
-    printRect(x, y, w, h, clearText, m_defaultStyle, _stringToU32String(str));
+    printRect(x, y, w, h, clearText, m_defaultStyle, str);
   }
   // Print an utf-8 string with autowrap inside a rectangle and default style
   void Console::printRect(const int x, const int y,
                           const unsigned w, const unsigned h,
-                          const bool clearText, const std::string& str)
+                          const bool clearText, const std::string_view str)
   {
-    printRect(x, y, w, h, clearText, m_defaultStyle, _stringToU32String(str));
+    printRect(x, y, w, h, clearText, m_defaultStyle, _decodeText(str));
   }
   // Print an utf-32 string with autowrap inside a rectangle and default style
   void Console::printRect(const int x, const int y,
                           const unsigned w, const unsigned h,
-                          const bool clearText, const std::u32string& str)
+                          const bool clearText, const std::u32string_view str)
   {
     printRect(x, y, w, h, clearText, m_defaultStyle, str);
   }
@@ -335,29 +469,27 @@ namespace LRTerminal
                           const unsigned w, const unsigned h,
                           const bool clearText, const TextStyle& style, const char* fmt, ...)
   {
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
+    const std::string_view str = _formatText(buffer, fmt, args);
     va_end(args);
-    va_start(args, fmt);
-    std::string str = _computeString(size, fmt, args);
-    va_end(args);
-    printRect(x, y, w, h, clearText, style, _stringToU32String(str));
+    printRect(x, y, w, h, clearText, style, str);
   }
    // Print an utf-8 string with autowrap inside a rectangle and specific style
   void Console::printRect(const int x, const int y,
                           const unsigned w, const unsigned h,
-                          const bool clearText, const TextStyle& style, const std::string& str)
+                          const bool clearText, const TextStyle& style, const std::string_view str)
   {
-    printRect(x, y, w, h, clearText, style, _stringToU32String(str));
+    printRect(x, y, w, h, clearText, style, _decodeText(str));
   }
   // Print an utf-32 string with autowrap inside a rectangle and specific style
   void Console::printRect(const int x, const int y,
                           const unsigned w, const unsigned h,
-                          const bool clearText, const TextStyle& style, const std::u32string& str)
+                          const bool clearText, const TextStyle& style, const std::u32string_view str)
   {
-    // Compute the lines
-    std::vector<std::u32string> split = _splitRect(w, str);
+    // Compute the lines, usually already wrapped by getHeightRect or the previous frame
+    const std::vector<TextLine>& lines = m_textLayouts.getLines(str, w);
     // Compute the reference position according to the alignment
     int xPos = x;
     Alignment align = style.getAlignment();
@@ -379,30 +511,28 @@ namespace LRTerminal
     TextStyle txtStyle = style;
     txtStyle.setBackgroundFlag(BackgroundFlag::NONE);
     // Print the strings
-    for (unsigned i = 0u; (i < split.size()) && (i < h); ++i)
+    for (unsigned i = 0u; (i < lines.size()) && (i < h); ++i)
     {
-      print(xPos, y + i, txtStyle, split.at(i));
+      print(xPos, y + i, txtStyle, str.substr(lines[i].start, lines[i].length));
     }
   }
   // Get the number of lines for an autowrapped text
   unsigned Console::getHeightRect(const unsigned w, const char* fmt, ...)
   {
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    std::string str = _computeString(size, fmt, args);
+    const std::string_view str = _formatText(buffer, fmt, args);
     va_end(args);
-    return getHeightRect(w, _stringToU32String(str));
+    return getHeightRect(w, str);
   }
-  unsigned Console::getHeightRect(const unsigned w, const std::string& str)
+  unsigned Console::getHeightRect(const unsigned w, const std::string_view str)
   {
-    return getHeightRect(w, _stringToU32String(str));
+    return getHeightRect(w, _decodeText(str));
   }
-  unsigned Console::getHeightRect(const unsigned w, const std::u32string& str)
+  unsigned Console::getHeightRect(const unsigned w, const std::u32string_view str)
   {
-    return _splitRect(w, str).size();
+    return m_textLayouts.getLines(str, w).size();
   }
 
   // Fill a rectangle with the defaut style
@@ -415,19 +545,84 @@ namespace LRTerminal
   void Console::rect(const int x, const int y, const unsigned w, const unsigned h,
                      const bool clearText, const TextStyle& style)
   {
-    for (unsigned j = 0; j < h; ++j)
+    // Only the part of the rectangle inside the viewport is filled
+    const int xStart = std::max(x + m_viewport.x, m_viewport.xMin);
+    const int yStart = std::max(y + m_viewport.y, m_viewport.yMin);
+    const int xEnd = std::min(x + m_viewport.x + static_cast<int>(w), m_viewport.xMax);
+    const int yEnd = std::min(y + m_viewport.y + static_cast<int>(h), m_viewport.yMax);
+    const uint32_t foreground = style.getForeground().toXRGB();
+    const uint8_t font = static_cast<uint8_t>(style.getFont());
+    for (int j = yStart; j < yEnd; ++j)
     {
-      for (unsigned i = 0; i < w; ++i)
+      const CellChunk& chunk = _resolveRow(j);
+      for (int i = xStart; i < xEnd; ++i)
       {
-        char32_t codePoint = getChar(x + i, y + j);
-        if (clearText)
-        {
-          codePoint = 0u;
-        }
-        setChar(x + i, y + j, codePoint, style);
+        const unsigned index = _cellIndex(i, j);
+        const char32_t codePoint = clearText ? 0u : chunk.codePoints[index];
+        _setCell(i, j, codePoint, foreground,
+                 _computeBackground(chunk.backgrounds[index], style.getBackground(), style.getBackgroundFlag()), font);
       }
     }
   }
+  // Scroll the content of a rectangle
+  void Console::scroll(const int x, const int y, const unsigned w, const unsigned h, const int dx, const int dy)
+  {
+    // Only the part of the rectangle inside the console is scrolled
+    const int xStart = std::max(x, 0);
+    const int yStart = std::max(y, 0);
+    const int xEnd = std::min(x + static_cast<int>(w), static_cast<int>(m_width));
+    const int yEnd = std::min(y + static_cast<int>(h), static_cast<int>(m_height));
+    if ((xStart >= xEnd) || (yStart >= yEnd) || ((dx == 0) && (dy == 0)))
+    {
+      return;
+    }
+    TextStyle clearStyle = m_defaultStyle;
+    clearStyle.setBackgroundFlag(BackgroundFlag::SET);
+    if ((std::abs(dx) >= (xEnd - xStart)) || (std::abs(dy) >= (yEnd - yStart)))
+    {
+      // Everything is moved out of the rectangle
+      rect(xStart, yStart, xEnd - xStart, yEnd - yStart, true, clearStyle);
+      return;
+    }
+    // Move the cells, their dirty state follows them
+    for (int j = yStart; j < yEnd; ++j)
+    {
+      _resolveRow(j);
+    }
+    // The rows may be in different chunks, so they are moved one at a time,
+    // in an order where a row is read before being overwritten
+    const int count = (xEnd - xStart) - std::abs(dx);
+    const int xFirst = std::max(xStart, xStart + dx);
+    const int jFirst = (dy > 0) ? yEnd - 1 : yStart;
+    const int jLast = (dy > 0) ? yStart + dy - 1 : yEnd + dy;
+    const int jStep = (dy > 0) ? -1 : 1;
+    for (int j = jFirst; j != jLast; j += jStep)
+    {
+      CellChunk& dstChunk = *m_chunks[j >> C_CHUNK_ROW_SHIFT];
+      const CellChunk& srcChunk = *m_chunks[(j - dy) >> C_CHUNK_ROW_SHIFT];
+      const unsigned dstIndex = _cellIndex(xFirst, j);
+      const unsigned srcIndex = _cellIndex(xFirst - dx, j - dy);
+      Utils::moveCells(&dstChunk.codePoints[dstIndex], &srcChunk.codePoints[srcIndex], count);
+      Utils::moveCells(&dstChunk.foregrounds[dstIndex], &srcChunk.foregrounds[srcIndex], count);
+      Utils::moveCells(&dstChunk.backgrounds[dstIndex], &srcChunk.backgrounds[srcIndex], count);
+      Utils::moveCells(&dstChunk.fonts[dstIndex], &srcChunk.fonts[srcIndex], count);
+    }
+    m_dirtyCells.moveRect(xStart, yStart, xEnd, yEnd, dx, dy);
+    _onScroll(xStart, yStart, xEnd, yEnd, dx, dy);
+    // Clear the uncovered rows, then the uncovered columns
+    if (dy != 0)
+    {
+      const int rowsStart = (dy > 0) ? yStart : yEnd + dy;
+      rect(xStart, rowsStart, xEnd - xStart, std::abs(dy), true, clearStyle);
+    }
+    if (dx != 0)
+    {
+      const int columnsStart = (dx > 0) ? xStart : xEnd + dx;
+      const int rowsStart = (dy > 0) ? yStart + dy : yStart;
+      rect(columnsStart, rowsStart, std::abs(dx), (yEnd - yStart) - std::abs(dy), true, clearStyle);
+    }
+  }
+
   // Draw an horizontal line: fill a line with the codepoint for an horizontal line
   void Console::hline(const int x, const int y, const unsigned l)
   {
@@ -461,23 +656,20 @@ namespace LRTerminal
   void Console::printFrame(const int x, const int y, const unsigned w, const unsigned h,
                            const bool clearText, const char* fmt, ...)
   {
-    std::string title;
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
+    const std::string_view title = _formatText(buffer, fmt, args);
     va_end(args);
-    va_start(args, fmt);
-    title = _computeString(size, fmt, args);
-    va_end(args);
-    printFrame(x, y, w, h, clearText, m_defaultStyle, _stringToU32String(title));
+    printFrame(x, y, w, h, clearText, m_defaultStyle, title);
   }
   void Console::printFrame(const int x, const int y, const unsigned w, const unsigned h,
-                           const bool clearText, const std::string& title)
+                           const bool clearText, const std::string_view title)
   {
-    printFrame(x, y, w, h, clearText, m_defaultStyle, _stringToU32String(title));
+    printFrame(x, y, w, h, clearText, m_defaultStyle, _decodeText(title));
   }
   void Console::printFrame(const int x, const int y, const unsigned w, const unsigned h,
-                           const bool clearText, const std::u32string& title)
+                           const bool clearText, const std::u32string_view title)
   {
     printFrame(x, y, w, h, clearText, m_defaultStyle, title);
   }
@@ -491,27 +683,24 @@ namespace LRTerminal
                            const bool clearText, const TextStyle& style,
                            const char* fmt, ...)
   {
-    std::string title;
+    char buffer[C_FORMAT_BUFFER_SIZE];
     va_list args;
     va_start(args, fmt);
-    int size = _computeStringSize(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    title = _computeString(size, fmt, args);
+    const std::string_view title = _formatText(buffer, fmt, args);
     va_end(args);
-    printFrame(x, y, w, h, clearText, style, _stringToU32String(title));
+    printFrame(x, y, w, h, clearText, style, title);
   }
   //
   void Console::printFrame(const int x, const int y, const unsigned w, const unsigned h,
                            const bool clearText, const TextStyle& style,
-                           const std::string& title)
+                           const std::string_view title)
   {
-    printFrame(x, y, w, h, clearText, style, _stringToU32String(title));
+    printFrame(x, y, w, h, clearText, style, _decodeText(title));
   }
   //
   void Console::printFrame(const int x, const int y, const unsigned w, const unsigned h,
                            const bool clearText, const TextStyle& style,
-                           const std::u32string& title)
+                           const std::u32string_view title)
   {
     // A frame is at least 2 in width and 2 in height
     if ((w > 1u) && (h > 1u))
@@ -537,7 +726,7 @@ namespace LRTerminal
       // Bottom Right
       setChar(x + w - 1u, y + h - 1u, style.getBoxDrawingCharacter(BoxDrawing::UP_AND_LEFT), style);
       // Title
-      if (title != U"")
+      if (!title.empty())
       {
         TextStyle txtStyle = style;
         txtStyle.setBackgroundFlag(BackgroundFlag::NONE);
@@ -546,6 +735,41 @@ namespace LRTerminal
     }
   }
 
+  // Snapshots
+  Console Console::snapshot(void) const
+  {
+    return Console(*this);
+  }
+
+  void Console::restore(const Console& snapshot)
+  {
+    if ((snapshot.m_width != m_width) || (snapshot.m_height != m_height))
+    {
+      throw std::invalid_argument("The snapshot does not have the size of the console");
+    }
+    // Mark the rows that change before sharing the chunks
+    for (unsigned y = 0u; y < m_height; ++y)
+    {
+      if (!_isSameRow(snapshot, y))
+      {
+        for (unsigned x = 0u; x < m_width; ++x)
+        {
+          m_dirtyCells.mark(x, y);
+        }
+      }
+    }
+    m_chunks = snapshot.m_chunks;
+    m_clearedRow = snapshot.m_clearedRow;
+    m_clearForeground = snapshot.m_clearForeground;
+    m_clearBackground = snapshot.m_clearBackground;
+    m_clearFont = snapshot.m_clearFont;
+    // The generations are relative to the clear generation of each console
+    for (unsigned y = 0u; y < m_height; ++y)
+    {
+      m_rowGenerations[y] = snapshot._isRowCleared(y) ? m_clearGeneration - 1u : m_clearGeneration;
+    }
+  }
+
   // Getters
   // Width of console
   unsigned Console::getWidth(void) const
@@ -592,7 +816,7 @@ namespace LRTerminal
   // Code point of a cell
   char32_t Console::getChar(const int x, const int y) const
   {
-    return m_cells[_cellIndex(x, y)].getCodePoint();
+    return _getCodePointAt(x, y);
   }
   // Get the style of a cell
   // Note: values from the default style are used when they aren't present at cell level
@@ -608,19 +832,19 @@ namespace LRTerminal
     return ret;
   }
   // Background of a cell
-  const Color& Console::getBackground(const int x, const int y) const
+  Color Console::getBackground(const int x, const int y) const
   {
-    return m_cells[_cellIndex(x, y)].getBackground();
+    return Color::fromXRGB(_getBackgroundAt(x, y));
   }
   // Foreground of a cell
-  const Color& Console::getForeground(const int x, const int y) const
+  Color Console::getForeground(const int x, const int y) const
   {
-    return m_cells[_cellIndex(x, y)].getForeground();
+    return Color::fromXRGB(_getForegroundAt(x, y));
   }
   // Font of a cell
   Font Console::getFont(const int x, const int y) const
   {
-    return m_cells[_cellIndex(x, y)].getFont();
+    return static_cast<Font>(_getFontAt(x, y));
   }
 
   // Blitting
@@ -635,78 +859,182 @@ namespace LRTerminal
       && (foregroundAlpha <= 1.0f) && (backgroundAlpha <= 1.0f)
       && ((foregroundAlpha > 0.0f) || (backgroundAlpha > 0.0f)))
     {
-      for (int j = 0; j < hSrc; ++j)
+      // Only blit the area inside both consoles, computed once
+      const int iStart = std::max({0, -xSrc, -xDst});
+      const int jStart = std::max({0, -ySrc, -yDst});
+      const int iEnd = std::min({wSrc, static_cast<int>(src.m_width) - xSrc, static_cast<int>(dst.m_width) - xDst});
+      const int jEnd = std::min({hSrc, static_cast<int>(src.m_height) - ySrc, static_cast<int>(dst.m_height) - yDst});
+      if ((iStart >= iEnd) || (jStart >= jEnd))
+      {
+        return;
+      }
+      const unsigned count = iEnd - iStart;
+      // The alpha levels are converted once into fixed-point weights
+      BlitWeights weights;
+      weights.background = Color::toWeight(backgroundAlpha);
+      weights.foreground = Color::toWeight(foregroundAlpha);
+      weights.foregroundLow = Color::toWeight(2.0f * foregroundAlpha);
+      weights.foregroundHigh = Color::toWeight(2.0f * (foregroundAlpha - 0.5f));
+      weights.isForegroundLow = (foregroundAlpha < 0.5f);
+      const bool isOpaque = (foregroundAlpha == 1.0f) && (backgroundAlpha == 1.0f);
+      for (int j = jStart; j < jEnd; ++j)
+      {
+        const unsigned ySrcRow = ySrc + j;
+        const unsigned yDstRow = yDst + j;
+        // The source row stays valid when the destination is written:
+        // if both share a chunk, the destination writes into a copy of it
+        CellSpan srcSpan = src._getRowCells(ySrcRow);
+        const unsigned srcOffset = xSrc + iStart;
+        srcSpan.codePoints += srcOffset;
+        srcSpan.foregrounds += srcOffset;
+        srcSpan.backgrounds += srcOffset;
+        srcSpan.fonts += srcOffset;
+        if (isOpaque)
+        {
+          dst._blitRowOpaque(srcSpan, src.m_isIgnoreCellColorEnabled, src.m_ignoreCellColor.toXRGB(),
+                             xDst + iStart, yDstRow, count);
+        }
+        else
+        {
+          dst._blitRowAlpha(srcSpan, src.m_isIgnoreCellColorEnabled, src.m_ignoreCellColor.toXRGB(),
+                            weights, xDst + iStart, yDstRow, count);
+        }
+      }
+    }
+  }
+
+  // Blit a row of cells with full opacity
+  // This is the general case below with all the weights at 256
+  void Console::_blitRowOpaque(const CellSpan& src, const bool isIgnoreCellColorEnabled, const uint32_t ignoreCellColor,
+                               const unsigned x, const unsigned y, const unsigned count)
+  {
+    CellChunk& chunk = _resolveRow(y);
+    const unsigned dstIndex = _cellIndex(x, y);
+    char32_t* const codePoints = &chunk.codePoints[dstIndex];
+    uint32_t* const foregrounds = &chunk.foregrounds[dstIndex];
+    uint32_t* const backgrounds = &chunk.backgrounds[dstIndex];
+    uint8_t* const fonts = &chunk.fonts[dstIndex];
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      const uint32_t srcBackground = src.backgrounds[i];
+      if (isIgnoreCellColorEnabled && (srcBackground == ignoreCellColor))
+      {
+        continue;
+      }
+      const char32_t srcCodePoint = src.codePoints[i];
+      char32_t codePoint = codePoints[i];
+      uint8_t font = fonts[i];
+      uint32_t foreground = srcBackground;
+      if (!_isBlank(srcCodePoint))
       {
-        for (int i = 0; i < wSrc; ++i)
+        // The font of the destination is kept if it already displays the same character
+        if (_isBlank(codePoint) || (codePoint != srcCodePoint))
         {
-          const int xPosSrc = xSrc + i;
-          const int yPosSrc = ySrc + j;
-          const int xPosDst = xDst + i;
-          const int yPosDst = yDst + j;
-          // Only blit the area inside both consoles and the area should be blit
-          if ( src._isInside(xPosSrc, yPosSrc)
-            && dst._isInside(xPosDst, yPosDst)
-            && (   !src.m_isIgnoreCellColorEnabled
-                || (src.getBackground(xPosSrc, yPosSrc) != src.m_ignoreCellColor)))
-          {
-            // The foreground color and char depends on wether the area are blank or not
-            const ConsoleCell& srcCell = src.m_cells.at(src._cellIndex(xPosSrc, yPosSrc));
-            const ConsoleCell& dstCell = dst.m_cells.at(dst._cellIndex(xPosDst, yPosDst));
-            //
-            // CodePoint to set
-            char32_t codePoint = dstCell.getCodePoint();
-            // Style to set
-            TextStyle style = dst.getStyle(xPosDst, yPosDst);
-            style.setBackgroundFlag(BackgroundFlag::SET);
-            // Background
-            style.setBackground(
-              Color::lerp(dstCell.getBackground(), srcCell.getBackground(), backgroundAlpha)
-            );
-            //
-            // The effect applied for the foreground and the codePoint to display
-            // depends on several parameters
-            // Based on the LibTCOD implementation of console blitting
-            if (srcCell.isBlank())
-            {
-              style.setForeground(
-                Color::lerp(dstCell.getForeground(), srcCell.getBackground(), backgroundAlpha)
-              );
-            }
-            else if (dstCell.isBlank())
-            {
-              codePoint = srcCell.getCodePoint();
-              style.setFont(srcCell.getFont());
-              style.setForeground(
-                Color::lerp(dstCell.getBackground(), srcCell.getForeground(), foregroundAlpha)
-              );
-            }
-            else if (dstCell.getCodePoint() == srcCell.getCodePoint())
-            {
-              style.setForeground(
-                Color::lerp(dstCell.getForeground(), srcCell.getForeground(), foregroundAlpha)
-              );
-            }
-            else if (foregroundAlpha < 0.5f)
-            {
-              style.setForeground(
-                Color::lerp(dstCell.getForeground(), dstCell.getForeground(), 2.0f * foregroundAlpha)
-              );
-            }
-            else
-            {
-              codePoint = srcCell.getCodePoint();
-              style.setFont(srcCell.getFont());
-              style.setForeground(
-                Color::lerp(dstCell.getBackground(), srcCell.getForeground(), 2.0f * (foregroundAlpha - 0.5f))
-              );
-            }
-            // Update the char
-            dst.setChar(xPosDst, yPosDst, codePoint, style);
-          }
+          font = src.fonts[i];
         }
+        codePoint = srcCodePoint;
+        foreground = src.foregrounds[i];
+      }
+      if ( (codePoints[i] != codePoint) || (foregrounds[i] != foreground)
+        || (backgrounds[i] != srcBackground) || (fonts[i] != font))
+      {
+        codePoints[i] = codePoint;
+        foregrounds[i] = foreground;
+        backgrounds[i] = srcBackground;
+        fonts[i] = font;
+        m_dirtyCells.mark(x + i, y);
+      }
+    }
+  }
+
+  // Blit a row of cells with partial opacity
+  // The colors to interpolate are chosen for the whole row, then interpolated with Blend::lerpRow
+  void Console::_blitRowAlpha(const CellSpan& src, const bool isIgnoreCellColorEnabled, const uint32_t ignoreCellColor,
+                              const BlitWeights& weights, const unsigned x, const unsigned y, const unsigned count)
+  {
+    CellChunk& chunk = _resolveRow(y);
+    const unsigned dstIndex = _cellIndex(x, y);
+    char32_t* const codePoints = &chunk.codePoints[dstIndex];
+    uint32_t* const foregrounds = &chunk.foregrounds[dstIndex];
+    uint32_t* const backgrounds = &chunk.backgrounds[dstIndex];
+    uint8_t* const fonts = &chunk.fonts[dstIndex];
+    // Buffers: new backgrounds, foregrounds to interpolate, new foregrounds
+    m_blitColors.resize(4u * count);
+    m_blitWeights.resize(2u * count);
+    uint32_t* const newBackgrounds = &m_blitColors[0u];
+    uint32_t* const foregroundsA = &m_blitColors[count];
+    uint32_t* const foregroundsB = &m_blitColors[2u * count];
+    uint32_t* const newForegrounds = &m_blitColors[3u * count];
+    uint16_t* const backgroundWeights = &m_blitWeights[0u];
+    uint16_t* const foregroundWeights = &m_blitWeights[count];
+    // Background
+    std::fill(backgroundWeights, backgroundWeights + count, weights.background);
+    Blend::lerpRow(backgrounds, src.backgrounds, backgroundWeights, count, newBackgrounds);
+    //
+    // The effect applied for the foreground and the codePoint to display
+    // depends on several parameters
+    // Based on the LibTCOD implementation of console blitting
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      const char32_t srcCodePoint = src.codePoints[i];
+      const char32_t dstCodePoint = codePoints[i];
+      if (_isBlank(srcCodePoint))
+      {
+        foregroundsA[i] = foregrounds[i];
+        foregroundsB[i] = src.backgrounds[i];
+        foregroundWeights[i] = weights.background;
+      }
+      else if (_isBlank(dstCodePoint) || (dstCodePoint == srcCodePoint))
+      {
+        foregroundsA[i] = _isBlank(dstCodePoint) ? backgrounds[i] : foregrounds[i];
+        foregroundsB[i] = src.foregrounds[i];
+        foregroundWeights[i] = weights.foreground;
+      }
+      else if (weights.isForegroundLow)
+      {
+        foregroundsA[i] = foregrounds[i];
+        foregroundsB[i] = foregrounds[i];
+        foregroundWeights[i] = weights.foregroundLow;
+      }
+      else
+      {
+        foregroundsA[i] = backgrounds[i];
+        foregroundsB[i] = src.foregrounds[i];
+        foregroundWeights[i] = weights.foregroundHigh;
+      }
+    }
+    Blend::lerpRow(foregroundsA, foregroundsB, foregroundWeights, count, newForegrounds);
+    // Update the cells
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      const uint32_t srcBackground = src.backgrounds[i];
+      if (isIgnoreCellColorEnabled && (srcBackground == ignoreCellColor))
+      {
+        continue;
+      }
+      const char32_t srcCodePoint = src.codePoints[i];
+      char32_t codePoint = codePoints[i];
+      uint8_t font = fonts[i];
+      // The source character replaces the destination one if the destination is blank,
+      // or if the foreground is opaque enough
+      if ( !_isBlank(srcCodePoint) && (codePoint != srcCodePoint)
+        && (_isBlank(codePoint) || !weights.isForegroundLow))
+      {
+        codePoint = srcCodePoint;
+        font = src.fonts[i];
+      }
+      if ( (codePoints[i] != codePoint) || (foregrounds[i] != newForegrounds[i])
+        || (backgrounds[i] != newBackgrounds[i]) || (fonts[i] != font))
+      {
+        codePoints[i] = codePoint;
+        foregrounds[i] = newForegrounds[i];
+        backgrounds[i] = newBackgrounds[i];
+        fonts[i] = font;
+        m_dirtyCells.mark(x + i, y);
       }
     }
   }
+
   // Transparent color when bliting: cells with background set to the key color are not blit
   void Console::setIgnoreCellColor(const Color& col)
   {
@@ -718,15 +1046,58 @@ namespace LRTerminal
   {
     m_isIgnoreCellColorEnabled = false;
   }
+  // Ignore cell color
+  bool Console::isIgnoreCellColorEnabled(void) const
+  {
+    return m_isIgnoreCellColorEnabled;
+  }
+  const Color& Console::getIgnoreCellColor(void) const
+  {
+    return m_ignoreCellColor;
+  }
 
   bool Console::_isDirty(const int x, const int y) const
   {
-    return m_cells[_cellIndex(x, y)].isDirty();
+    return m_dirtyCells.isDirty(x, y);
   }
 
   void Console::_unsetDirty(const int x, const int y)
   {
-    m_cells[_cellIndex(x, y)].unsetDirty();
+    m_dirtyCells.unmark(x, y);
+  }
+
+  // Nothing to do by default when scrolling
+  void Console::_onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                          const int dx, const int dy)
+  {
+  }
+
+  // Content of a row, the cleared rows are read from a row of cleared cells
+  Console::CellSpan Console::_getRowCells(const unsigned y) const
+  {
+    CellSpan ret;
+    if (_isRowCleared(y))
+    {
+      ret.codePoints = m_clearedRow->codePoints.data();
+      ret.foregrounds = m_clearedRow->foregrounds.data();
+      ret.backgrounds = m_clearedRow->backgrounds.data();
+      ret.fonts = m_clearedRow->fonts.data();
+    }
+    else
+    {
+      const CellChunk& chunk = _getChunk(y);
+      const unsigned index = _getRowIndex(y);
+      ret.codePoints = &chunk.codePoints[index];
+      ret.foregrounds = &chunk.foregrounds[index];
+      ret.backgrounds = &chunk.backgrounds[index];
+      ret.fonts = &chunk.fonts[index];
+    }
+    return ret;
+  }
+
+  DirtyTracker& Console::_getDirtyCells(void)
+  {
+    return m_dirtyCells;
   }
 
   bool Console::_isInside(const int x, const int y) const
@@ -734,80 +1105,93 @@ namespace LRTerminal
     return ((x >= 0) && (x < static_cast<int>(m_width)) && (y >= 0) && (y < static_cast<int>(m_height)));
   }
 
-  int Console::_cellIndex(const int x, const int y) const
+  bool Console::_mapCell(const int x, const int y, int& xCell, int& yCell) const
+  {
+    xCell = x + m_viewport.x;
+    yCell = y + m_viewport.y;
+    return (xCell >= m_viewport.xMin) && (xCell < m_viewport.xMax)
+        && (yCell >= m_viewport.yMin) && (yCell < m_viewport.yMax);
+  }
+
+  unsigned Console::_cellIndex(const int x, const int y) const
   {
-    return x + (y * m_width);
+    return _getRowIndex(y) + x;
   }
 
-  int Console::_computeStringSize(const char* fmt, va_list args)
+  // Chunks of rows
+  const Console::CellChunk& Console::_getChunk(const unsigned y) const
   {
-    return vsnprintf(NULL, 0u, fmt, args);
+    return *m_chunks[y >> C_CHUNK_ROW_SHIFT];
   }
 
-  std::string Console::_computeString(int stringSize, const char* fmt, va_list args)
+  unsigned Console::_getRowIndex(const unsigned y) const
   {
-    std::string ret;
-    if (stringSize >= 0)
+    return (y & (C_CHUNK_ROWS - 1u)) * m_width;
+  }
+
+  bool Console::_isSameRow(const Console& that, const unsigned y) const
+  {
+    bool ret = false;
+    const bool isCleared = _isRowCleared(y);
+    if (isCleared != that._isRowCleared(y))
+    {
+      ret = false;
+    }
+    else if (isCleared)
     {
-      char* buff = new char[stringSize + 1];
-      (void)vsnprintf(buff, stringSize + 1, fmt, args);
-      ret = buff;
-      delete[] buff;
+      ret = (m_clearForeground == that.m_clearForeground) && (m_clearBackground == that.m_clearBackground)
+         && (m_clearFont == that.m_clearFont);
+    }
+    else
+    {
+      // A shared chunk has not been modified by either console
+      ret = (m_chunks[y >> C_CHUNK_ROW_SHIFT] == that.m_chunks[y >> C_CHUNK_ROW_SHIFT]);
     }
     return ret;
   }
 
-  std::u32string Console::_stringToU32String(const std::string str)
+  std::string_view Console::_formatText(char* const buffer, const char* fmt, va_list args)
   {
-    // Convert from utf-8 char* to utf-32 char32_t* in order to update the console cells
-    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> u32conv;
-    return u32conv.from_bytes(str);
+    return _formatText(buffer, m_formattedText, fmt, args);
   }
 
-  std::vector<std::u32string> Console::_splitRect(const unsigned w, const std::u32string& str)
-  {
-    std::vector<std::u32string> ret;
-    // Split the string along the spaces
-    unsigned startingPos = 0u;
-    unsigned nextSpace = 0u;
-    std::u32string currentLine;
-    bool firstWord = true;
-    while (startingPos < str.size())
+  std::string_view Console::_formatText(char* const buffer, std::string& fallback, const char* fmt, va_list args)
+  {
+    std::string_view ret;
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    const int length = vsnprintf(buffer, C_FORMAT_BUFFER_SIZE, fmt, argsCopy);
+    va_end(argsCopy);
+    if ((length >= 0) && (static_cast<unsigned>(length) < C_FORMAT_BUFFER_SIZE))
     {
-      nextSpace = str.find(U' ', startingPos);
-      std::u32string word = str.substr(startingPos, nextSpace - startingPos);
-      // Check if we can add the word to the current line
-      if ((currentLine.size() + 1u + word.size()) < w)
-      {
-        if (firstWord)
-        {
-          currentLine.append(word);
-          firstWord = false;
-        }
-        else
-        {
-          currentLine.append(1, U' ').append(word);
-        }
-      }
-      else
-      {
-        // We can't append the word to the current line,
-        // Add the current line to the line list and initialize the next line with the word
-        ret.push_back(currentLine);
-        currentLine = word;
-      }
-      // compute the next starting position
-      if (nextSpace >= str.size())
-      {
-        // No next space, end the loop and add the current line to the line list
-        startingPos = str.size();
-        ret.push_back(currentLine);
-      }
-      else
-      {
-        startingPos = nextSpace + 1u;
-      }
+      ret = std::string_view(buffer, length);
+    }
+    else if (length >= 0)
+    {
+      // Too long for the stack buffer, the string is formatted again in the fallback buffer
+      fallback.resize(length + 1);
+      (void)vsnprintf(&fallback[0], length + 1, fmt, args);
+      ret = std::string_view(fallback.data(), length);
+    }
+    return ret;
+  }
+
+  const std::u32string& Console::_decodeText(const std::string_view str)
+  {
+    Utf8::decode(str.data(), str.size(), m_decodedText);
+    return m_decodedText;
+  }
 
+  int Console::_computeStartPosition(const int x, const unsigned length, const Alignment align)
+  {
+    int ret = x;
+    if (align == Alignment::CENTER)
+    {
+      ret = x - (length / 2u);
+    }
+    else if (align == Alignment::RIGHT)
+    {
+      ret = x - length + 1;
     }
     return ret;
   }
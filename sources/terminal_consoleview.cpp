@@ -0,0 +1,288 @@
+#include "terminal_consoleview.h"
+#include <algorithm>
+
+namespace LRTerminal
+{
+  ////
+  // Scope
+  ConsoleView::Scope::Scope(const ConsoleView& view):
+      m_console(view.m_console), m_previous(view.m_console.m_viewport)
+  {
+    // The console may have been resized since the view was made, it is never addressed past its size
+    Console::Viewport& viewport = m_console.m_viewport;
+    viewport = view.m_viewport;
+    viewport.xMax = std::min(viewport.xMax, static_cast<int>(m_console.m_width));
+    viewport.yMax = std::min(viewport.yMax, static_cast<int>(m_console.m_height));
+  }
+
+  ConsoleView::Scope::~Scope()
+  {
+    m_console.m_viewport = m_previous;
+  }
+
+  ////
+  // ConsoleView
+  // Constructors
+  ConsoleView::ConsoleView(Console& console, const int x, const int y, const unsigned w, const unsigned h):
+      m_console(console), m_width(w), m_height(h)
+  {
+    m_viewport.x = x;
+    m_viewport.y = y;
+    m_viewport.xMin = std::max(x, 0);
+    m_viewport.yMin = std::max(y, 0);
+    m_viewport.xMax = std::min(x + static_cast<int>(w), static_cast<int>(console.getWidth()));
+    m_viewport.yMax = std::min(y + static_cast<int>(h), static_cast<int>(console.getHeight()));
+  }
+
+  ConsoleView::ConsoleView(const ConsoleView& parent, const int x, const int y, const unsigned w, const unsigned h):
+      m_console(parent.m_console), m_width(w), m_height(h)
+  {
+    m_viewport.x = parent.m_viewport.x + x;
+    m_viewport.y = parent.m_viewport.y + y;
+    m_viewport.xMin = std::max(m_viewport.x, parent.m_viewport.xMin);
+    m_viewport.yMin = std::max(m_viewport.y, parent.m_viewport.yMin);
+    m_viewport.xMax = std::min(m_viewport.x + static_cast<int>(w), parent.m_viewport.xMax);
+    m_viewport.yMax = std::min(m_viewport.y + static_cast<int>(h), parent.m_viewport.yMax);
+  }
+
+  // Getters
+  Console& ConsoleView::getConsole(void) const
+  {
+    return m_console;
+  }
+
+  unsigned ConsoleView::getWidth(void) const
+  {
+    return m_width;
+  }
+
+  unsigned ConsoleView::getHeight(void) const
+  {
+    return m_height;
+  }
+
+  // Fill the view with the default style of the console
+  void ConsoleView::clear(void)
+  {
+    TextStyle style = m_console.getDefaultStyle();
+    style.setBackgroundFlag(BackgroundFlag::SET);
+    rect(0, 0, m_width, m_height, true, style);
+  }
+
+  // Cells
+  void ConsoleView::setChar(const int x, const int y, const char32_t c)
+  {
+    Scope scope(*this);
+    m_console.setChar(x, y, c);
+  }
+  void ConsoleView::setChar(const int x, const int y, const char32_t c, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.setChar(x, y, c, style);
+  }
+  void ConsoleView::setStyle(const int x, const int y, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.setStyle(x, y, style);
+  }
+  void ConsoleView::setBackground(const int x, const int y, const Color& col,
+                                  const BackgroundFlag flag)
+  {
+    Scope scope(*this);
+    m_console.setBackground(x, y, col, flag);
+  }
+  void ConsoleView::setForeground(const int x, const int y, const Color& col)
+  {
+    Scope scope(*this);
+    m_console.setForeground(x, y, col);
+  }
+  void ConsoleView::setFont(const int x, const int y, const Font font)
+  {
+    Scope scope(*this);
+    m_console.setFont(x, y, font);
+  }
+
+  // Printing
+  void ConsoleView::print(const int x, const int y, const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.print(x, y, str);
+  }
+  void ConsoleView::print(const int x, const int y, const std::string_view str)
+  {
+    Scope scope(*this);
+    m_console.print(x, y, str);
+  }
+  void ConsoleView::print(const int x, const int y, const std::u32string_view str)
+  {
+    Scope scope(*this);
+    m_console.print(x, y, str);
+  }
+  void ConsoleView::print(const int x, const int y, const TextStyle& style, const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.print(x, y, style, str);
+  }
+  void ConsoleView::print(const int x, const int y, const TextStyle& style, const std::string_view str)
+  {
+    Scope scope(*this);
+    m_console.print(x, y, style, str);
+  }
+  void ConsoleView::print(const int x, const int y, const TextStyle& style, const std::u32string_view str)
+  {
+    Scope scope(*this);
+    m_console.print(x, y, style, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const std::string_view str)
+  {
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const std::u32string_view str)
+  {
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const TextStyle& style, const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, style, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const TextStyle& style, const std::string_view str)
+  {
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, style, str);
+  }
+  void ConsoleView::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                              const bool clearText, const TextStyle& style, const std::u32string_view str)
+  {
+    Scope scope(*this);
+    m_console.printRect(x, y, w, h, clearText, style, str);
+  }
+
+  // Shapes
+  void ConsoleView::rect(const int x, const int y, const unsigned w, const unsigned h,
+                         const bool clearText)
+  {
+    Scope scope(*this);
+    m_console.rect(x, y, w, h, clearText);
+  }
+  void ConsoleView::rect(const int x, const int y, const unsigned w, const unsigned h,
+                         const bool clearText, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.rect(x, y, w, h, clearText, style);
+  }
+  void ConsoleView::hline(const int x, const int y, const unsigned l)
+  {
+    Scope scope(*this);
+    m_console.hline(x, y, l);
+  }
+  void ConsoleView::hline(const int x, const int y, const unsigned l, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.hline(x, y, l, style);
+  }
+  void ConsoleView::vline(const int x, const int y, const unsigned l)
+  {
+    Scope scope(*this);
+    m_console.vline(x, y, l);
+  }
+  void ConsoleView::vline(const int x, const int y, const unsigned l, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.vline(x, y, l, style);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, str);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const std::string_view title)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, title);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const std::u32string_view title)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, title);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const TextStyle& style)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, style);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const TextStyle& style,
+                               const char* fmt, ...)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    const std::string_view str = m_console._formatText(buffer, fmt, args);
+    va_end(args);
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, style, str);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const TextStyle& style,
+                               const std::string_view title)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, style, title);
+  }
+  void ConsoleView::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                               const bool clearText, const TextStyle& style,
+                               const std::u32string_view title)
+  {
+    Scope scope(*this);
+    m_console.printFrame(x, y, w, h, clearText, style, title);
+  }
+
+}
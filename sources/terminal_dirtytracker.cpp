@@ -0,0 +1,132 @@
+#include "terminal_dirtytracker.h"
+#include <algorithm>
+
+namespace LRTerminal
+{
+  // Constructor
+  DirtyTracker::DirtyTracker(const unsigned width, const unsigned height):
+      m_width(width), m_height(height), m_wordsPerRow((width + 63u) / 64u)
+  {
+    m_cells.resize(m_wordsPerRow * m_height);
+    m_rows.resize((m_height + 63u) / 64u);
+    markAll();
+  }
+
+  // Mark all the cells as dirty
+  void DirtyTracker::markAll(void)
+  {
+    if ((m_width == 0u) || (m_height == 0u))
+    {
+      return;
+    }
+    // Only the bits of existing cells and rows are set
+    const uint64_t lastCellWord = ((m_width & 63u) == 0u) ? ~UINT64_C(0) : ((UINT64_C(1) << (m_width & 63u)) - 1u);
+    const uint64_t lastRowWord = ((m_height & 63u) == 0u) ? ~UINT64_C(0) : ((UINT64_C(1) << (m_height & 63u)) - 1u);
+    for (unsigned row = 0u; row < m_height; ++row)
+    {
+      uint64_t* const words = &m_cells[row * m_wordsPerRow];
+      std::fill(words, words + m_wordsPerRow - 1u, ~UINT64_C(0));
+      words[m_wordsPerRow - 1u] = lastCellWord;
+    }
+    std::fill(m_rows.begin(), m_rows.end() - 1, ~UINT64_C(0));
+    m_rows.back() = lastRowWord;
+  }
+
+  // Mark a cell as clean
+  void DirtyTracker::unmark(const unsigned x, const unsigned y)
+  {
+    // The row summary is kept, it may only point to a clean row
+    m_cells[(y * m_wordsPerRow) + (x >> 6)] &= ~(UINT64_C(1) << (x & 63u));
+  }
+
+  // Move the dirty cells of a rectangle
+  void DirtyTracker::moveRect(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                              const int dx, const int dy)
+  {
+    // Take the dirty cells out of the rectangle
+    m_movedCells.clear();
+    forEachDirtyCell(y0, y1, [this, x0, x1](const unsigned x, const unsigned y) {
+      if ((x >= x0) && (x < x1))
+      {
+        m_movedCells.push_back((static_cast<uint64_t>(y) << 32) | x);
+      }
+    });
+    for (auto iter = m_movedCells.begin(); iter != m_movedCells.end(); ++iter)
+    {
+      unmark(static_cast<uint32_t>(*iter), static_cast<uint32_t>(*iter >> 32));
+    }
+    // And put back those still inside
+    for (auto iter = m_movedCells.begin(); iter != m_movedCells.end(); ++iter)
+    {
+      const int x = static_cast<int>(static_cast<uint32_t>(*iter)) + dx;
+      const int y = static_cast<int>(*iter >> 32) + dy;
+      if ((x >= static_cast<int>(x0)) && (x < static_cast<int>(x1)) && (y >= static_cast<int>(y0)) && (y < static_cast<int>(y1)))
+      {
+        mark(x, y);
+      }
+    }
+    // The uncovered cells: full rows, then columns on the remaining rows
+    const unsigned rowsStart = (dy > 0) ? y0 : y1 + dy;
+    const unsigned rowsEnd = (dy > 0) ? y0 + dy : y1;
+    const unsigned columnsStart = (dx > 0) ? x0 : x1 + dx;
+    const unsigned columnsEnd = (dx > 0) ? x0 + dx : x1;
+    for (unsigned y = y0; y < y1; ++y)
+    {
+      const bool isRowUncovered = (y >= rowsStart) && (y < rowsEnd);
+      const unsigned xStart = isRowUncovered ? x0 : columnsStart;
+      const unsigned xEnd = isRowUncovered ? x1 : columnsEnd;
+      for (unsigned x = xStart; x < xEnd; ++x)
+      {
+        mark(x, y);
+      }
+    }
+  }
+
+  bool DirtyTracker::isDirty(const unsigned x, const unsigned y) const
+  {
+    return ((m_cells[(y * m_wordsPerRow) + (x >> 6)] >> (x & 63u)) & 1u) != 0u;
+  }
+
+  bool DirtyTracker::isEmpty(void) const
+  {
+    return nextDirtyRow(0u) >= m_height;
+  }
+
+  // First row at or after a given row containing dirty cells
+  unsigned DirtyTracker::nextDirtyRow(const unsigned row) const
+  {
+    unsigned ret = m_height;
+    if (row < m_height)
+    {
+      unsigned word = row >> 6;
+      // Ignore the rows before the given one in the first word
+      uint64_t bits = m_rows[word] & (~UINT64_C(0) << (row & 63u));
+      while ((bits == 0u) && (++word < m_rows.size()))
+      {
+        bits = m_rows[word];
+      }
+      if (bits != 0u)
+      {
+        ret = (word << 6) + _countTrailingZeros(bits);
+      }
+    }
+    return ret;
+  }
+
+  // Clear the cells of the rows [firstRow; lastRow[
+  void DirtyTracker::clearRows(const unsigned firstRow, const unsigned lastRow)
+  {
+    for (unsigned row = nextDirtyRow(firstRow); row < lastRow; row = nextDirtyRow(row + 1u))
+    {
+      uint64_t* const words = &m_cells[row * m_wordsPerRow];
+      std::fill(words, words + m_wordsPerRow, UINT64_C(0));
+    }
+  }
+
+  // Clear the summary of the dirty rows
+  void DirtyTracker::clearRowSummary(void)
+  {
+    std::fill(m_rows.begin(), m_rows.end(), UINT64_C(0));
+  }
+
+}
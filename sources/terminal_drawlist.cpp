@@ -0,0 +1,414 @@
+#include "terminal_drawlist.h"
+#include "terminal_utf8.h"
+#include <algorithm>
+
+namespace LRTerminal
+{
+  // Constructor
+  DrawList::DrawList():
+      m_isFlattened(false)
+  {
+  }
+
+  void DrawList::clear(void)
+  {
+    m_commands.clear();
+    m_styles.clear();
+    m_text.clear();
+    m_isFlattened = false;
+  }
+
+  unsigned DrawList::getCommandCount(void) const
+  {
+    return m_commands.size();
+  }
+
+  ////
+  // Recording
+  void DrawList::setChar(const int x, const int y, const char32_t c, const TextStyle& style)
+  {
+    _record(CommandType::SET_CHAR, x, y, 1u, 1u, false, _addStyle(style), c, 0u);
+  }
+
+  void DrawList::print(const int x, const int y, const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::print(const int x, const int y, const TextStyle& style, const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::print(const int x, const int y, const std::string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::print(const int x, const int y, const std::u32string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::print(const int x, const int y, const TextStyle& style, const std::string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::print(const int x, const int y, const TextStyle& style, const std::u32string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT, x, y, 0u, 0u, false, _addStyle(style), offset, m_text.size() - offset);
+  }
+
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const TextStyle& style, const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const std::string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const std::u32string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const TextStyle& style, const std::string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::printRect(const int x, const int y, const unsigned w, const unsigned h,
+                           const bool clearText, const TextStyle& style, const std::u32string_view str)
+  {
+    const uint32_t offset = _addText(str);
+    _record(CommandType::PRINT_RECT, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+
+  void DrawList::rect(const int x, const int y, const unsigned w, const unsigned h,
+                      const bool clearText)
+  {
+    _record(CommandType::RECT, x, y, w, h, clearText, C_DEFAULT_STYLE, 0u, 0u);
+  }
+  void DrawList::rect(const int x, const int y, const unsigned w, const unsigned h,
+                      const bool clearText, const TextStyle& style)
+  {
+    _record(CommandType::RECT, x, y, w, h, clearText, _addStyle(style), 0u, 0u);
+  }
+  void DrawList::hline(const int x, const int y, const unsigned l)
+  {
+    _record(CommandType::HLINE, x, y, l, 1u, false, C_DEFAULT_STYLE, 0u, 0u);
+  }
+  void DrawList::hline(const int x, const int y, const unsigned l, const TextStyle& style)
+  {
+    _record(CommandType::HLINE, x, y, l, 1u, false, _addStyle(style), 0u, 0u);
+  }
+  void DrawList::vline(const int x, const int y, const unsigned l)
+  {
+    _record(CommandType::VLINE, x, y, 1u, l, false, C_DEFAULT_STYLE, 0u, 0u);
+  }
+  void DrawList::vline(const int x, const int y, const unsigned l, const TextStyle& style)
+  {
+    _record(CommandType::VLINE, x, y, 1u, l, false, _addStyle(style), 0u, 0u);
+  }
+
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText)
+  {
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, C_DEFAULT_STYLE, 0u, 0u);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const TextStyle& style)
+  {
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, _addStyle(style), 0u, 0u);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const TextStyle& style,
+                            const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    const uint32_t offset = _addText(fmt, args);
+    va_end(args);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const std::string_view title)
+  {
+    const uint32_t offset = _addText(title);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const std::u32string_view title)
+  {
+    const uint32_t offset = _addText(title);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, C_DEFAULT_STYLE, offset, m_text.size() - offset);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const TextStyle& style,
+                            const std::string_view title)
+  {
+    const uint32_t offset = _addText(title);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+  void DrawList::printFrame(const int x, const int y, const unsigned w, const unsigned h,
+                            const bool clearText, const TextStyle& style,
+                            const std::u32string_view title)
+  {
+    const uint32_t offset = _addText(title);
+    _record(CommandType::PRINT_FRAME, x, y, w, h, clearText, _addStyle(style), offset, m_text.size() - offset);
+  }
+
+  void DrawList::_record(const CommandType type, const int x, const int y, const unsigned w, const unsigned h,
+                         const bool clearText, const uint32_t style, const uint32_t textOffset, const uint32_t textLength)
+  {
+    Command command;
+    command.type = type;
+    command.clearText = clearText;
+    command.style = style;
+    command.x = x;
+    command.y = y;
+    command.w = w;
+    command.h = h;
+    command.textOffset = textOffset;
+    command.textLength = textLength;
+    m_commands.push_back(command);
+    // The flattened cells no longer match the operations
+    m_isFlattened = false;
+  }
+
+  uint32_t DrawList::_addText(const std::u32string_view str)
+  {
+    const uint32_t ret = m_text.size();
+    m_text.append(str);
+    return ret;
+  }
+
+  uint32_t DrawList::_addText(const std::string_view str)
+  {
+    const uint32_t ret = m_text.size();
+    Utf8::forEachCodePoint(str.data(), str.size(), [this](const char32_t codePoint) {
+      m_text.push_back(codePoint);
+    });
+    return ret;
+  }
+
+  uint32_t DrawList::_addText(const char* fmt, va_list args)
+  {
+    char buffer[Console::C_FORMAT_BUFFER_SIZE];
+    std::string fallback;
+    return _addText(Console::_formatText(buffer, fallback, fmt, args));
+  }
+
+  uint32_t DrawList::_addStyle(const TextStyle& style)
+  {
+    m_styles.push_back(style);
+    return m_styles.size() - 1u;
+  }
+
+  ////
+  // Drawing
+  void DrawList::draw(Console& console, const int x, const int y) const
+  {
+    if (m_isFlattened)
+    {
+      for (auto iter = m_spans.begin(); iter != m_spans.end(); ++iter)
+      {
+        Console::CellSpan cells;
+        cells.codePoints = &m_codePoints[iter->firstCell];
+        cells.foregrounds = &m_foregrounds[iter->firstCell];
+        cells.backgrounds = &m_backgrounds[iter->firstCell];
+        cells.fonts = &m_fonts[iter->firstCell];
+        console._setCells(x + iter->x, y + iter->y, iter->count, cells);
+      }
+    }
+    else
+    {
+      for (auto iter = m_commands.begin(); iter != m_commands.end(); ++iter)
+      {
+        _drawCommand(*iter, console, x, y);
+      }
+    }
+  }
+
+  void DrawList::_drawCommand(const Command& command, Console& console, const int x, const int y) const
+  {
+    const TextStyle& style = (command.style == C_DEFAULT_STYLE) ? console.getDefaultStyle() : m_styles[command.style];
+    const std::u32string_view text(m_text.data() + command.textOffset, command.textLength);
+    const int xCommand = x + command.x;
+    const int yCommand = y + command.y;
+    switch (command.type)
+    {
+      case CommandType::SET_CHAR:
+        console.setChar(xCommand, yCommand, command.textOffset, style);
+        break;
+      case CommandType::PRINT:
+        console.print(xCommand, yCommand, style, text);
+        break;
+      case CommandType::PRINT_RECT:
+        console.printRect(xCommand, yCommand, command.w, command.h, command.clearText, style, text);
+        break;
+      case CommandType::RECT:
+        console.rect(xCommand, yCommand, command.w, command.h, command.clearText, style);
+        break;
+      case CommandType::HLINE:
+        console.hline(xCommand, yCommand, command.w, style);
+        break;
+      case CommandType::VLINE:
+        console.vline(xCommand, yCommand, command.h, style);
+        break;
+      case CommandType::PRINT_FRAME:
+        console.printFrame(xCommand, yCommand, command.w, command.h, command.clearText, style, text);
+        break;
+    }
+  }
+
+  ////
+  // Flattening
+  void DrawList::flatten(const unsigned width, const unsigned height, const TextStyle& defaultStyle)
+  {
+    m_spans.clear();
+    m_codePoints.clear();
+    m_foregrounds.clear();
+    m_backgrounds.clear();
+    m_fonts.clear();
+    // Draw the operations on a cleared console, and find the cells they write
+    Console console(width, height);
+    console.setDefaultStyle(defaultStyle);
+    console.clear();
+    DirtyTracker cells(width, height);
+    cells.clearRows(0u, height);
+    cells.clearRowSummary();
+    for (auto iter = m_commands.begin(); iter != m_commands.end(); ++iter)
+    {
+      _drawCommand(*iter, console, 0, 0);
+      _markCells(*iter, defaultStyle, cells, width, height);
+    }
+    // Group the written cells into spans
+    Console::CellSpan row = Console::CellSpan();
+    int rowY = -1;
+    cells.forEachDirtyCell(0u, height, [&](const unsigned x, const unsigned y) {
+      if (static_cast<int>(y) != rowY)
+      {
+        row = console._getRowCells(y);
+        rowY = y;
+      }
+      if ( m_spans.empty() || (m_spans.back().y != static_cast<int32_t>(y))
+        || (m_spans.back().x + static_cast<int32_t>(m_spans.back().count) != static_cast<int32_t>(x)))
+      {
+        Span span;
+        span.x = x;
+        span.y = y;
+        span.count = 0u;
+        span.firstCell = m_codePoints.size();
+        m_spans.push_back(span);
+      }
+      ++m_spans.back().count;
+      m_codePoints.push_back(row.codePoints[x]);
+      m_foregrounds.push_back(row.foregrounds[x]);
+      m_backgrounds.push_back(row.backgrounds[x]);
+      m_fonts.push_back(row.fonts[x]);
+    });
+    m_isFlattened = true;
+  }
+
+  bool DrawList::isFlattened(void) const
+  {
+    return m_isFlattened;
+  }
+
+  void DrawList::_markCells(const Command& command, const TextStyle& defaultStyle, DirtyTracker& cells,
+                            const unsigned width, const unsigned height) const
+  {
+    // Cells of the rectangle (x, y, w, h) inside the flattened area
+    auto markRect = [&cells, width, height](const int x, const int y, const unsigned w, const unsigned h) {
+      const int xStart = std::max(x, 0);
+      const int yStart = std::max(y, 0);
+      const int xEnd = std::min(x + static_cast<int>(w), static_cast<int>(width));
+      const int yEnd = std::min(y + static_cast<int>(h), static_cast<int>(height));
+      for (int j = yStart; j < yEnd; ++j)
+      {
+        for (int i = xStart; i < xEnd; ++i)
+        {
+          cells.mark(i, j);
+        }
+      }
+    };
+    const TextStyle& style = (command.style == C_DEFAULT_STYLE) ? defaultStyle : m_styles[command.style];
+    // Cells of the lines printed by printRect, which can go past the rectangle
+    auto markLines = [&](const int x, const int y, const unsigned w, const unsigned h) {
+      int xPos = x;
+      if (style.getAlignment() == Alignment::CENTER)
+      {
+        xPos = x + (w / 2);
+      }
+      else if (style.getAlignment() == Alignment::RIGHT)
+      {
+        xPos = x + w - 1;
+      }
+      LineBreaker breaker(std::u32string_view(m_text.data() + command.textOffset, command.textLength), w);
+      TextLine line;
+      for (unsigned i = 0u; (i < h) && breaker.next(line); ++i)
+      {
+        markRect(Console::_computeStartPosition(xPos, line.length, style.getAlignment()), y + i, line.length, 1u);
+      }
+    };
+    switch (command.type)
+    {
+      case CommandType::PRINT:
+        markRect(Console::_computeStartPosition(command.x, command.textLength, style.getAlignment()), command.y,
+                 command.textLength, 1u);
+        break;
+      case CommandType::PRINT_RECT:
+        markRect(command.x, command.y, command.w, command.h);
+        markLines(command.x, command.y, command.w, command.h);
+        break;
+      case CommandType::PRINT_FRAME:
+        // A frame is at least 2 in width and 2 in height, the title is printed in its top bar
+        if ((command.w > 1u) && (command.h > 1u))
+        {
+          markRect(command.x, command.y, command.w, command.h);
+          markLines(command.x + 1, command.y, command.w - 2u, 1u);
+        }
+        break;
+      default:
+        markRect(command.x, command.y, command.w, command.h);
+        break;
+    }
+  }
+
+}
@@ -1,20 +1,54 @@
 #include "terminal_fontdata.h"
+#include <cstddef>
 
 namespace LRTerminal
 {
+  ////
+  // Glyph table
+  void FontData::GlyphTable::reset(const uint32_t missingGlyph)
+  {
+    blocks.assign(C_BLOCK_COUNT, 0u);
+    pages.resize(1u);
+    pages.front().fill(missingGlyph);
+  }
+
+  void FontData::GlyphTable::set(const char32_t codePoint, const uint32_t glyph)
+  {
+    uint16_t& page = blocks[codePoint >> C_PAGE_SHIFT];
+    if (page == 0u)
+    {
+      // First glyph of the block, it gets its own copy of the empty page
+      pages.push_back(pages.front());
+      page = pages.size() - 1u;
+    }
+    pages[page][codePoint & (C_PAGE_SIZE - 1u)] = glyph;
+  }
 
-  FontData::FontData(unsigned glyphWidth, unsigned glyphHeight):
-      m_glyphWidth(glyphWidth), m_glyphHeight(glyphHeight)
+  ////
+  // Font data
+  FontData::FontData(GlyphAtlas& atlas):
+      m_atlas(atlas), m_glyphWidth(atlas.getGlyphWidth()), m_glyphHeight(atlas.getGlyphHeight()),
+      m_fallback(NULL)
   {
-    // Add a default blank glyph at code point 0
-    m_glyphMap.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(0u),
-                       std::forward_as_tuple(m_glyphWidth, m_glyphHeight));
+    // The blank glyph of the atlas is the glyph of the code point 0
+    m_ownGlyphs.reset(C_NO_GLYPH);
+    m_ownGlyphs.set(0u, 0u);
+    resolve();
   }
 
   FontData::~FontData()
   {
-    m_glyphMap.clear();
+    // Give the slots of the glyphs back to the atlas
+    for (auto iter = m_ownGlyphs.pages.begin(); iter != m_ownGlyphs.pages.end(); ++iter)
+    {
+      for (auto glyph = iter->begin(); glyph != iter->end(); ++glyph)
+      {
+        if ((*glyph != C_NO_GLYPH) && (*glyph != 0u))
+        {
+          m_atlas.removeGlyph(*glyph);
+        }
+      }
+    }
   }
 
   // Add a glyph at a code point
@@ -22,23 +56,8 @@ namespace LRTerminal
                           const uint8_t* const srcImage,
                           unsigned srcWidth, unsigned srcHeight, unsigned srcX, unsigned srcY)
   {
-    // If the glyph is not nul, erase it
-    if (codePoint != 0u)
-    {
-      m_glyphMap.erase(codePoint);
-    }
-    // Do not add blank glyphs to the font, as it's the default glyph
-    // The code point 0 is reserved as the blank glyph and is added in the constructor
-    if ((codePoint != 0u) && (!_checkIsBlank(srcImage, srcWidth, srcHeight, srcX, srcY)))
-    {
-      m_glyphMap.emplace(std::piecewise_construct,
-                         std::forward_as_tuple(codePoint),
-                         std::forward_as_tuple(
-                           m_glyphWidth, m_glyphHeight,
-                           srcImage,
-                           srcWidth, srcHeight, srcX, srcY
-                        ));
-    }
+    _addGlyph(codePoint, srcImage, srcWidth, srcHeight, srcX, srcY);
+    resolve();
   }
 
   void FontData::addGlyphs(char32_t codePointStart,
@@ -51,12 +70,61 @@ namespace LRTerminal
     {
       for (unsigned i = 0; i < nbGlyphsW; ++i)
       {
-        addGlyph(codePointStart + (j * nbGlyphsW) + i,
-                 srcImage,
-                 srcWidth, srcHeight,
-                 i * m_glyphWidth,
-                 j * m_glyphHeight);
+        _addGlyph(codePointStart + (j * nbGlyphsW) + i,
+                  srcImage,
+                  srcWidth, srcHeight,
+                  i * m_glyphWidth,
+                  j * m_glyphHeight);
+      }
+    }
+    resolve();
+  }
+
+  void FontData::setGlyphs(const char32_t* const codePoints, const unsigned* const glyphs,
+                           const unsigned firstGlyph, const unsigned count, const bool isResolved)
+  {
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      const char32_t codePoint = codePoints[i];
+      if ((codePoint == 0u) || (codePoint >= (C_BLOCK_COUNT << C_PAGE_SHIFT)))
+      {
+        continue;
       }
+      const uint32_t glyph = firstGlyph + glyphs[i];
+      m_atlas.retainGlyph(glyph);
+      const uint32_t previous = m_ownGlyphs.get(codePoint);
+      if (previous != C_NO_GLYPH)
+      {
+        m_atlas.removeGlyph(previous);
+      }
+      m_ownGlyphs.set(codePoint, glyph);
+    }
+    if (isResolved)
+    {
+      resolve();
+    }
+  }
+
+  void FontData::_addGlyph(char32_t codePoint,
+                           const uint8_t* const srcImage,
+                           unsigned srcWidth, unsigned srcHeight, unsigned srcX, unsigned srcY)
+  {
+    // The code point 0 is reserved as the blank glyph and is added in the constructor
+    if ((codePoint == 0u) || (codePoint >= (C_BLOCK_COUNT << C_PAGE_SHIFT)))
+    {
+      return;
+    }
+    // If the glyph is already present, erase it
+    const uint32_t previous = m_ownGlyphs.get(codePoint);
+    if (previous != C_NO_GLYPH)
+    {
+      m_atlas.removeGlyph(previous);
+      m_ownGlyphs.set(codePoint, C_NO_GLYPH);
+    }
+    // Do not add blank glyphs to the font, as it's the default glyph
+    if (!_checkIsBlank(srcImage, srcWidth, srcHeight, srcX, srcY))
+    {
+      m_ownGlyphs.set(codePoint, m_atlas.addGlyph(srcImage, srcWidth, srcHeight, srcX, srcY));
     }
   }
 
@@ -79,15 +147,11 @@ namespace LRTerminal
   }
 
   // Getters
-  const Glyph& FontData::getGlyph(char32_t codePoint) const
+  Glyph FontData::getGlyph(char32_t codePoint) const
   {
-    auto found = m_glyphMap.find(codePoint);
     // If the glyph is not present, defaults to the blank glyph located at codepoint 0
-    if (found == m_glyphMap.end())
-    {
-      found = m_glyphMap.find(0u);
-    }
-    return found->second;
+    const uint32_t index = hasGlyph(codePoint) ? m_ownGlyphs.get(codePoint) : 0u;
+    return m_atlas.getGlyph(index);
   }
 
   unsigned FontData::getGlyphWidth() const
@@ -102,8 +166,46 @@ namespace LRTerminal
 
   bool FontData::hasGlyph(char32_t codePoint) const
   {
-    auto found = m_glyphMap.find(codePoint);
-    return found != m_glyphMap.end();
+    return (codePoint < (C_BLOCK_COUNT << C_PAGE_SHIFT)) && (m_ownGlyphs.get(codePoint) != C_NO_GLYPH);
+  }
+
+  // Fallback
+  void FontData::setFallback(const FontData* fallback, const bool isResolved)
+  {
+    m_fallback = fallback;
+    if (isResolved)
+    {
+      resolve();
+    }
+  }
+
+  void FontData::resolve(void)
+  {
+    m_resolvedGlyphs.reset(0u);
+    for (unsigned block = 0u; block < C_BLOCK_COUNT; ++block)
+    {
+      const uint16_t ownPage = m_ownGlyphs.blocks[block];
+      const uint16_t fallbackPage = (m_fallback != NULL) ? m_fallback->m_ownGlyphs.blocks[block] : 0u;
+      // The blocks without glyphs in both fonts keep the empty page
+      if ((ownPage != 0u) || (fallbackPage != 0u))
+      {
+        m_resolvedGlyphs.pages.push_back(m_resolvedGlyphs.pages.front());
+        m_resolvedGlyphs.blocks[block] = m_resolvedGlyphs.pages.size() - 1u;
+        GlyphPage& page = m_resolvedGlyphs.pages.back();
+        for (unsigned i = 0u; i < C_PAGE_SIZE; ++i)
+        {
+          uint32_t glyph = m_ownGlyphs.pages[ownPage][i];
+          if ((glyph == C_NO_GLYPH) && (m_fallback != NULL))
+          {
+            glyph = m_fallback->m_ownGlyphs.pages[fallbackPage][i];
+          }
+          if (glyph != C_NO_GLYPH)
+          {
+            page[i] = glyph;
+          }
+        }
+      }
+    }
   }
 
 }
@@ -0,0 +1,671 @@
+#include "terminal_fontfile.h"
+#include "terminal_utf8.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TERMINAL_FONTFILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace LRTerminal::FontFile
+{
+  ////
+  // Read-only content of a file, mapped in memory when the platform supports it
+  class MappedFile
+  {
+  public:
+    MappedFile(const std::string& path);
+    ~MappedFile(void);
+    bool isOpen(void) const;
+    const uint8_t* getData(void) const;
+    size_t getSize(void) const;
+  private:
+    // Copy constructor & operator = are declared but not implemented
+    MappedFile(const MappedFile& that);
+    MappedFile& operator=(const MappedFile& that);
+
+    const uint8_t* m_data;
+    size_t m_size;
+    bool m_isMapped;
+    std::vector<uint8_t> m_buffer; // Content of the file if it is not mapped
+  };
+
+  MappedFile::MappedFile(const std::string& path):
+      m_data(NULL), m_size(0u), m_isMapped(false)
+  {
+#ifdef TERMINAL_FONTFILE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+      struct stat fileStat;
+      if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0))
+      {
+        void* const data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+          m_data = static_cast<const uint8_t*>(data);
+          m_size = fileStat.st_size;
+          m_isMapped = true;
+        }
+      }
+      close(fd);
+    }
+#else
+    FILE* const file = fopen(path.c_str(), "rb");
+    if (file != NULL)
+    {
+      uint8_t buffer[4096];
+      size_t count = 0u;
+      while ((count = fread(buffer, 1u, sizeof(buffer), file)) > 0u)
+      {
+        m_buffer.insert(m_buffer.end(), buffer, buffer + count);
+      }
+      fclose(file);
+      m_data = m_buffer.data();
+      m_size = m_buffer.size();
+    }
+#endif
+  }
+
+  MappedFile::~MappedFile(void)
+  {
+#ifdef TERMINAL_FONTFILE_MMAP
+    if (m_isMapped)
+    {
+      munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+#endif
+  }
+
+  bool MappedFile::isOpen(void) const
+  {
+    return (m_data != NULL) && (m_size > 0u);
+  }
+
+  const uint8_t* MappedFile::getData(void) const
+  {
+    return m_data;
+  }
+
+  size_t MappedFile::getSize(void) const
+  {
+    return m_size;
+  }
+
+  ////
+  // Bitmap font
+  unsigned BitmapFont::getGlyphSize(void) const
+  {
+    return ((glyphWidth + 7u) / 8u) * glyphHeight;
+  }
+
+  unsigned BitmapFont::getImageCount(void) const
+  {
+    const unsigned glyphSize = getGlyphSize();
+    return (glyphSize > 0u) ? (bits.size() / glyphSize) : 0u;
+  }
+
+  BitmapFont BitmapFont::resize(const unsigned width, const unsigned height) const
+  {
+    BitmapFont ret;
+    ret.glyphWidth = width;
+    ret.glyphHeight = height;
+    ret.codePoints = codePoints;
+    ret.glyphs = glyphs;
+    const unsigned imageCount = getImageCount();
+    const unsigned srcBytesPerRow = (glyphWidth + 7u) / 8u;
+    const unsigned dstBytesPerRow = (width + 7u) / 8u;
+    ret.bits.assign(imageCount * ret.getGlyphSize(), 0u);
+    // Offsets of the source glyph in the new glyph, negative if the source is cropped
+    const int dx = (static_cast<int>(width) - static_cast<int>(glyphWidth)) / 2;
+    const int dy = (static_cast<int>(height) - static_cast<int>(glyphHeight)) / 2;
+    for (unsigned i = 0u; i < imageCount; ++i)
+    {
+      const uint8_t* const src = &bits[i * getGlyphSize()];
+      uint8_t* const dst = &ret.bits[i * ret.getGlyphSize()];
+      for (unsigned y = 0u; y < glyphHeight; ++y)
+      {
+        const int dstY = static_cast<int>(y) + dy;
+        for (unsigned x = 0u; (x < glyphWidth) && (dstY >= 0) && (dstY < static_cast<int>(height)); ++x)
+        {
+          const int dstX = static_cast<int>(x) + dx;
+          if ((dstX >= 0) && (dstX < static_cast<int>(width)) && ((src[(y * srcBytesPerRow) + (x / 8u)] >> (x % 8u)) & 1u))
+          {
+            dst[(dstY * dstBytesPerRow) + (dstX / 8u)] |= 1u << (dstX % 8u);
+          }
+        }
+      }
+    }
+    return ret;
+  }
+
+  // The coordinates are in units of 1 / (srcWidth * width) horizontally and 1 / (srcHeight * height) vertically,
+  // so the pixel edges of both sizes are integers
+  void scaleImages(const uint8_t* const bits, const unsigned count,
+                   const unsigned srcWidth, const unsigned srcHeight,
+                   const unsigned width, const unsigned height, std::vector<uint8_t>& out)
+  {
+    const unsigned srcBytesPerRow = (srcWidth + 7u) / 8u;
+    const unsigned bytesPerRow = (width + 7u) / 8u;
+    const unsigned area = srcWidth * srcHeight;
+    const size_t first = out.size();
+    out.resize(first + (count * bytesPerRow * height), 0u);
+    for (unsigned n = 0u; n < count; ++n)
+    {
+      const uint8_t* const src = bits + (n * srcBytesPerRow * srcHeight);
+      uint8_t* const dst = &out[first + (n * bytesPerRow * height)];
+      for (unsigned y = 0u; y < height; ++y)
+      {
+        const unsigned top = y * srcHeight;
+        const unsigned bottom = top + srcHeight;
+        for (unsigned x = 0u; x < width; ++x)
+        {
+          const unsigned left = x * srcWidth;
+          const unsigned right = left + srcWidth;
+          unsigned coverage = 0u;
+          for (unsigned sy = top / height; (sy * height) < bottom; ++sy)
+          {
+            const unsigned coverageY = std::min(bottom, (sy + 1u) * height) - std::max(top, sy * height);
+            for (unsigned sx = left / width; (sx * width) < right; ++sx)
+            {
+              if ((src[(sy * srcBytesPerRow) + (sx / 8u)] >> (sx % 8u)) & 1u)
+              {
+                coverage += coverageY * (std::min(right, (sx + 1u) * width) - std::max(left, sx * width));
+              }
+            }
+          }
+          if ((coverage * 8u) >= (area * 3u))
+          {
+            dst[(y * bytesPerRow) + (x / 8u)] |= 1u << (x % 8u);
+          }
+        }
+      }
+    }
+  }
+
+  // Check if the last image of a font is blank
+  static bool _isLastImageBlank(const BitmapFont& font)
+  {
+    const unsigned glyphSize = font.getGlyphSize();
+    bool ret = true;
+    for (unsigned i = font.bits.size() - glyphSize; (i < font.bits.size()) && ret; ++i)
+    {
+      ret = font.bits[i] == 0u;
+    }
+    return ret;
+  }
+
+  ////
+  // Formats
+  static const uint8_t C_PSF2_MAGIC[4] = {0x72u, 0xB5u, 0x4Au, 0x86u};
+  static const uint32_t C_PSF2_HAS_UNICODE_TABLE = 0x01u;
+  static const uint8_t C_PSF2_SEPARATOR = 0xFFu;
+  static const uint8_t C_PSF2_START_SEQUENCE = 0xFEu;
+  // Sanity limit of the size of the glyphs
+  static const unsigned C_MAX_GLYPH_SIZE = 256u;
+
+  Format getFormat(const uint8_t* const data, const size_t size)
+  {
+    Format ret = Format::UNKNOWN;
+    if ((size >= 4u) && (memcmp(data, C_PSF2_MAGIC, 4u) == 0))
+    {
+      ret = Format::PSF2;
+    }
+    else if ((size >= 9u) && (memcmp(data, "STARTFONT", 9u) == 0))
+    {
+      ret = Format::BDF;
+    }
+    return ret;
+  }
+
+  bool parse(const uint8_t* const data, const size_t size, BitmapFont& font)
+  {
+    bool ret = false;
+    switch (getFormat(data, size))
+    {
+      case Format::BDF:
+        ret = parseBDF(reinterpret_cast<const char*>(data), size, font);
+        break;
+      case Format::PSF2:
+        ret = parsePSF2(data, size, font);
+        break;
+      case Format::UNKNOWN:
+      default:
+        ret = false;
+        break;
+    }
+    return ret;
+  }
+
+  ////
+  // BDF: a text format, each glyph has its own bounding box placed relatively to the font bounding box
+  // The rows of the glyphs are in hexadecimal, the first pixel of a row is the highest bit of its first byte.
+  static bool _nextLine(const char*& it, const char* const end, std::string& line)
+  {
+    if (it == end)
+    {
+      return false;
+    }
+    const char* lineEnd = static_cast<const char*>(memchr(it, '\n', end - it));
+    if (lineEnd == NULL)
+    {
+      lineEnd = end;
+    }
+    line.assign(it, lineEnd);
+    if (!line.empty() && (line.back() == '\r'))
+    {
+      line.pop_back();
+    }
+    it = (lineEnd == end) ? end : lineEnd + 1;
+    return true;
+  }
+
+  static bool _startsWith(const std::string& line, const char* const keyword)
+  {
+    const size_t length = strlen(keyword);
+    return (line.compare(0u, length, keyword) == 0) && ((line.size() == length) || (line[length] == ' '));
+  }
+
+  static int _hexDigit(const char c)
+  {
+    int ret = -1;
+    if ((c >= '0') && (c <= '9'))
+    {
+      ret = c - '0';
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+      ret = c - 'A' + 10;
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+      ret = c - 'a' + 10;
+    }
+    return ret;
+  }
+
+  // The offsets of the bounding boxes are limited, so the positions of the pixels can not overflow
+  static bool _isValidOffset(const int offset)
+  {
+    return (offset >= -static_cast<int>(C_MAX_GLYPH_SIZE)) && (offset <= static_cast<int>(C_MAX_GLYPH_SIZE));
+  }
+
+  bool parseBDF(const char* const data, const size_t size, BitmapFont& font)
+  {
+    font = BitmapFont();
+    const char* it = data;
+    const char* const end = data + size;
+    std::string line;
+    if (!_nextLine(it, end, line) || !_startsWith(line, "STARTFONT"))
+    {
+      return false;
+    }
+    // Font bounding box, the glyphs are placed in it
+    int fontWidth = 0, fontHeight = 0, fontX = 0, fontY = 0;
+    bool hasBoundingBox = false;
+    // Current glyph
+    long encoding = -1;
+    int width = 0, height = 0, x = 0, y = 0;
+    while (_nextLine(it, end, line))
+    {
+      if (_startsWith(line, "FONTBOUNDINGBOX"))
+      {
+        // The size of the images can not change once glyphs have been read
+        if (hasBoundingBox)
+        {
+          return false;
+        }
+        hasBoundingBox = (sscanf(line.c_str(), "FONTBOUNDINGBOX %d %d %d %d", &fontWidth, &fontHeight, &fontX, &fontY) == 4)
+                         && (fontWidth > 0) && (fontHeight > 0)
+                         && (fontWidth <= static_cast<int>(C_MAX_GLYPH_SIZE)) && (fontHeight <= static_cast<int>(C_MAX_GLYPH_SIZE))
+                         && _isValidOffset(fontX) && _isValidOffset(fontY);
+        if (!hasBoundingBox)
+        {
+          return false;
+        }
+        font.glyphWidth = fontWidth;
+        font.glyphHeight = fontHeight;
+      }
+      else if (_startsWith(line, "STARTCHAR"))
+      {
+        encoding = -1;
+        width = height = x = y = 0;
+      }
+      else if (_startsWith(line, "ENCODING"))
+      {
+        // The glyphs without standard encoding are "ENCODING -1 n", they are ignored
+        if (sscanf(line.c_str(), "ENCODING %ld", &encoding) != 1)
+        {
+          encoding = -1;
+        }
+      }
+      else if (_startsWith(line, "BBX"))
+      {
+        if ((sscanf(line.c_str(), "BBX %d %d %d %d", &width, &height, &x, &y) != 4)
+            || (width < 0) || (height < 0)
+            || (width > static_cast<int>(C_MAX_GLYPH_SIZE)) || (height > static_cast<int>(C_MAX_GLYPH_SIZE))
+            || !_isValidOffset(x) || !_isValidOffset(y))
+        {
+          return false;
+        }
+      }
+      else if (_startsWith(line, "BITMAP"))
+      {
+        if (!hasBoundingBox)
+        {
+          return false;
+        }
+        const unsigned bytesPerRow = (font.glyphWidth + 7u) / 8u;
+        font.bits.resize(font.bits.size() + font.getGlyphSize(), 0u);
+        uint8_t* const image = &font.bits[font.bits.size() - font.getGlyphSize()];
+        // Position of the glyph bounding box in the font bounding box, from the top left
+        const int left = x - fontX;
+        const int top = (fontHeight + fontY) - (height + y);
+        for (int row = 0; row < height; ++row)
+        {
+          if (!_nextLine(it, end, line))
+          {
+            return false;
+          }
+          for (int col = 0; col < width; ++col)
+          {
+            const size_t digit = col / 4;
+            const int value = (digit < line.size()) ? _hexDigit(line[digit]) : -1;
+            if (value < 0)
+            {
+              return false;
+            }
+            const int dstX = left + col;
+            const int dstY = top + row;
+            if (((value >> (3 - (col % 4))) & 1) && (dstX >= 0) && (dstX < fontWidth) && (dstY >= 0) && (dstY < fontHeight))
+            {
+              image[(dstY * bytesPerRow) + (dstX / 8)] |= 1u << (dstX % 8);
+            }
+          }
+        }
+        // The blank glyphs and the glyphs outside of Unicode are not stored
+        if ((encoding <= 0) || (encoding >= 0x110000) || _isLastImageBlank(font))
+        {
+          font.bits.resize(font.bits.size() - font.getGlyphSize());
+        }
+        else
+        {
+          font.codePoints.push_back(static_cast<char32_t>(encoding));
+          font.glyphs.push_back(font.getImageCount() - 1u);
+        }
+      }
+      else if (_startsWith(line, "ENDFONT"))
+      {
+        break;
+      }
+    }
+    return hasBoundingBox;
+  }
+
+  ////
+  // PSF2: a binary format, a header followed by the glyphs, and an optional table of the code points of each glyph
+  // The first pixel of a row is the highest bit of its first byte.
+  static uint32_t _readUint32(const uint8_t* const data)
+  {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+           | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+
+  bool parsePSF2(const uint8_t* const data, const size_t size, BitmapFont& font)
+  {
+    font = BitmapFont();
+    if ((size < 32u) || (memcmp(data, C_PSF2_MAGIC, 4u) != 0))
+    {
+      return false;
+    }
+    const uint32_t headerSize = _readUint32(data + 8u);
+    const uint32_t flags = _readUint32(data + 12u);
+    const uint32_t glyphCount = _readUint32(data + 16u);
+    const uint32_t charSize = _readUint32(data + 20u);
+    const uint32_t height = _readUint32(data + 24u);
+    const uint32_t width = _readUint32(data + 28u);
+    const uint32_t bytesPerRow = (width + 7u) / 8u;
+    if ((width == 0u) || (height == 0u) || (width > C_MAX_GLYPH_SIZE) || (height > C_MAX_GLYPH_SIZE)
+        || (charSize < bytesPerRow * height) || (headerSize < 32u) || (headerSize > size)
+        || (glyphCount > (size - headerSize) / charSize))
+    {
+      return false;
+    }
+    font.glyphWidth = width;
+    font.glyphHeight = height;
+    // Images, with the bits of each byte in the order of the atlas
+    font.bits.assign(glyphCount * font.getGlyphSize(), 0u);
+    std::vector<bool> isBlank(glyphCount, true);
+    for (uint32_t i = 0u; i < glyphCount; ++i)
+    {
+      const uint8_t* const src = data + headerSize + (i * charSize);
+      uint8_t* const dst = &font.bits[i * font.getGlyphSize()];
+      for (uint32_t j = 0u; j < bytesPerRow * height; ++j)
+      {
+        uint8_t byte = src[j];
+        uint8_t reversed = 0u;
+        for (unsigned k = 0u; k < 8u; ++k)
+        {
+          reversed = (reversed << 1) | (byte & 1u);
+          byte >>= 1;
+        }
+        dst[j] = reversed;
+        isBlank[i] = isBlank[i] && (reversed == 0u);
+      }
+    }
+    // Code points
+    if (flags & C_PSF2_HAS_UNICODE_TABLE)
+    {
+      // For each glyph: its code points in UTF-8, then sequences of code points starting with 0xFE, then 0xFF
+      const char* it = reinterpret_cast<const char*>(data + headerSize + (glyphCount * charSize));
+      const char* const end = reinterpret_cast<const char*>(data + size);
+      for (uint32_t i = 0u; (i < glyphCount) && (it != end); ++i)
+      {
+        bool isSequence = false;
+        while ((it != end) && (static_cast<uint8_t>(*it) != C_PSF2_SEPARATOR))
+        {
+          if (static_cast<uint8_t>(*it) == C_PSF2_START_SEQUENCE)
+          {
+            // The sequences of combining characters are not supported
+            isSequence = true;
+            ++it;
+          }
+          else if (isSequence)
+          {
+            ++it;
+          }
+          else
+          {
+            // The invalid UTF-8 is decoded as the replacement character, it is not a code point of the glyph
+            const char* const start = it;
+            const char32_t codePoint = Utf8::decode(it, end);
+            const bool isInvalid = (codePoint == Utf8::C_REPLACEMENT_CHARACTER)
+                                   && ((it - start != 3) || (memcmp(start, "\xEF\xBF\xBD", 3u) != 0));
+            if ((codePoint != 0u) && !isInvalid && !isBlank[i])
+            {
+              font.codePoints.push_back(codePoint);
+              font.glyphs.push_back(i);
+            }
+          }
+        }
+        if (it != end)
+        {
+          ++it;
+        }
+      }
+    }
+    else
+    {
+      for (uint32_t i = 1u; i < glyphCount; ++i)
+      {
+        if (!isBlank[i])
+        {
+          font.codePoints.push_back(i);
+          font.glyphs.push_back(i);
+        }
+      }
+    }
+    return true;
+  }
+
+  ////
+  // Cache
+  // The file is the header, the code points, the glyphs of the code points, and the images
+  // All the values are in the byte order of the platform, the cache is only valid for the platform that wrote it.
+  struct CacheHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t glyphWidth;
+    uint32_t glyphHeight;
+    uint32_t imageCount;
+    uint32_t codePointCount;
+    uint32_t reserved;
+    uint64_t sourceSize; // Size and modification time of the font file
+    int64_t sourceTime;
+  };
+  static const char C_CACHE_MAGIC[8] = {'L', 'R', 'T', 'F', 'O', 'N', 'T', '\0'};
+  static const uint32_t C_CACHE_VERSION = 1u;
+
+  // Size and modification time of a file, false if it does not exist
+  static bool _getFileStamp(const std::string& path, uint64_t& size, int64_t& time)
+  {
+    struct stat fileStat;
+    const bool ret = stat(path.c_str(), &fileStat) == 0;
+    if (ret)
+    {
+      size = fileStat.st_size;
+      time = fileStat.st_mtime;
+    }
+    return ret;
+  }
+
+  std::string getCachePath(const std::string& path, const std::string& cacheDirectory)
+  {
+    // The name of the file, and a hash of its path so fonts of the same name do not share a cache (FNV-1a)
+    const size_t separator = path.find_last_of("/\\");
+    const std::string name = (separator == std::string::npos) ? path : path.substr(separator + 1u);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto iter = path.begin(); iter != path.end(); ++iter)
+    {
+      hash = (hash ^ static_cast<uint8_t>(*iter)) * 0x100000001b3ull;
+    }
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.lrtfont", static_cast<unsigned long long>(hash));
+    std::string ret = cacheDirectory;
+    if (!ret.empty() && (ret.back() != '/') && (ret.back() != '\\'))
+    {
+      ret += '/';
+    }
+    return ret + name + suffix;
+  }
+
+  static bool _readCache(const std::string& cachePath, const uint64_t sourceSize, const int64_t sourceTime,
+                         BitmapFont& font)
+  {
+    MappedFile file(cachePath);
+    if (!file.isOpen() || (file.getSize() < sizeof(CacheHeader)))
+    {
+      return false;
+    }
+    CacheHeader header;
+    memcpy(&header, file.getData(), sizeof(CacheHeader));
+    if ((memcmp(header.magic, C_CACHE_MAGIC, sizeof(C_CACHE_MAGIC)) != 0) || (header.version != C_CACHE_VERSION)
+        || (header.sourceSize != sourceSize) || (header.sourceTime != sourceTime)
+        || (header.glyphWidth == 0u) || (header.glyphWidth > C_MAX_GLYPH_SIZE)
+        || (header.glyphHeight == 0u) || (header.glyphHeight > C_MAX_GLYPH_SIZE))
+    {
+      return false;
+    }
+    font.glyphWidth = header.glyphWidth;
+    font.glyphHeight = header.glyphHeight;
+    const size_t mappingSize = header.codePointCount * (sizeof(char32_t) + sizeof(uint32_t));
+    const size_t imagesSize = static_cast<size_t>(header.imageCount) * font.getGlyphSize();
+    if (file.getSize() != sizeof(CacheHeader) + mappingSize + imagesSize)
+    {
+      return false;
+    }
+    const uint8_t* data = file.getData() + sizeof(CacheHeader);
+    font.codePoints.resize(header.codePointCount);
+    memcpy(font.codePoints.data(), data, header.codePointCount * sizeof(char32_t));
+    data += header.codePointCount * sizeof(char32_t);
+    font.glyphs.resize(header.codePointCount);
+    memcpy(font.glyphs.data(), data, header.codePointCount * sizeof(uint32_t));
+    data += header.codePointCount * sizeof(uint32_t);
+    font.bits.assign(data, data + imagesSize);
+    // The glyphs must be in the images
+    for (auto iter = font.glyphs.begin(); iter != font.glyphs.end(); ++iter)
+    {
+      if (*iter >= header.imageCount)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool _writeCache(const std::string& cachePath, const uint64_t sourceSize, const int64_t sourceTime,
+                          const BitmapFont& font)
+  {
+    CacheHeader header;
+    memset(&header, 0, sizeof(CacheHeader));
+    memcpy(header.magic, C_CACHE_MAGIC, sizeof(C_CACHE_MAGIC));
+    header.version = C_CACHE_VERSION;
+    header.glyphWidth = font.glyphWidth;
+    header.glyphHeight = font.glyphHeight;
+    header.imageCount = font.getImageCount();
+    header.codePointCount = font.codePoints.size();
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    // Written next to the cache then renamed, so another instance never reads a partial cache
+    const std::string tempPath = cachePath + ".tmp";
+    FILE* const file = fopen(tempPath.c_str(), "wb");
+    if (file == NULL)
+    {
+      return false;
+    }
+    bool ret = (fwrite(&header, sizeof(CacheHeader), 1u, file) == 1u);
+    ret = ret && (fwrite(font.codePoints.data(), sizeof(char32_t), font.codePoints.size(), file) == font.codePoints.size());
+    ret = ret && (fwrite(font.glyphs.data(), sizeof(uint32_t), font.glyphs.size(), file) == font.glyphs.size());
+    ret = ret && (fwrite(font.bits.data(), 1u, font.bits.size(), file) == font.bits.size());
+    ret = (fclose(file) == 0) && ret;
+    ret = ret && (rename(tempPath.c_str(), cachePath.c_str()) == 0);
+    if (!ret)
+    {
+      remove(tempPath.c_str());
+    }
+    return ret;
+  }
+
+  ////
+  // Load a font file
+  bool load(const std::string& path, const std::string& cacheDirectory, BitmapFont& font)
+  {
+    uint64_t sourceSize = 0u;
+    int64_t sourceTime = 0;
+    if (!_getFileStamp(path, sourceSize, sourceTime))
+    {
+      return false;
+    }
+    const std::string cachePath = cacheDirectory.empty() ? std::string() : getCachePath(path, cacheDirectory);
+    if (!cachePath.empty() && _readCache(cachePath, sourceSize, sourceTime, font))
+    {
+      return true;
+    }
+    // Parse the font file, then cache it
+    MappedFile file(path);
+    bool ret = file.isOpen() && parse(file.getData(), file.getSize(), font);
+    if (ret && !cachePath.empty())
+    {
+      // The font is loaded even if the cache can not be written
+      (void)_writeCache(cachePath, sourceSize, sourceTime, font);
+    }
+    return ret;
+  }
+}
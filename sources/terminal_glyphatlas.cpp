@@ -0,0 +1,331 @@
+#include "terminal_glyphatlas.h"
+#include <cstring>
+
+namespace LRTerminal
+{
+  // Constructor
+  GlyphAtlas::GlyphAtlas(const unsigned glyphWidth, const unsigned glyphHeight):
+      m_glyphWidth(glyphWidth), m_glyphHeight(glyphHeight),
+      m_bytesPerRow((glyphWidth + 7u) / 8u),
+      m_blocksPerGlyph((glyphWidth * glyphHeight + C_GLYPH_ATLAS_ALIGNMENT - 1u) / C_GLYPH_ATLAS_ALIGNMENT),
+      m_monochromeBlocksPerGlyph((m_bytesPerRow * glyphHeight + C_MONOCHROME_GLYPH_ALIGNMENT - 1u) / C_MONOCHROME_GLYPH_ALIGNMENT),
+      m_isIndexed(true), m_sharedReferences(0u), m_sharedMonochromeReferences(0u)
+  {
+    // At least one block per glyph, so the glyphs have different addresses
+    if (m_blocksPerGlyph == 0u)
+    {
+      m_blocksPerGlyph = 1u;
+    }
+    if (m_monochromeBlocksPerGlyph == 0u)
+    {
+      m_monochromeBlocksPerGlyph = 1u;
+    }
+    // Blank glyph, it is never removed
+    const unsigned blank = _allocateMonochrome();
+    m_monochromeReferences[blank] = 1u;
+    m_glyphsByHash[_hash(_getBits(blank), getMonochromeGlyphSize(), true)] = blank;
+  }
+
+  unsigned GlyphAtlas::addGlyph(const uint8_t* const srcImage,
+                                const unsigned srcWidth, const unsigned srcHeight,
+                                const unsigned srcX, const unsigned srcY)
+  {
+    (void) srcHeight;
+    // Image of the glyph in the format of the atlas
+    const bool isMonochrome = _isMonochrome(srcImage, srcWidth, srcX, srcY);
+    std::vector<uint8_t> image;
+    if (isMonochrome)
+    {
+      // One bit per pixel, the first pixel of a row in the lowest bit of its first byte
+      image.assign(getMonochromeGlyphSize(), 0u);
+      for (unsigned j = 0u; j < m_glyphHeight; ++j)
+      {
+        const uint8_t* const srcRow = srcImage + ((srcY + j) * srcWidth) + srcX;
+        for (unsigned i = 0u; i < m_glyphWidth; ++i)
+        {
+          if (srcRow[i] != 0u)
+          {
+            image[(j * m_bytesPerRow) + (i / 8u)] |= 1u << (i % 8u);
+          }
+        }
+      }
+    }
+    else
+    {
+      image.resize(m_glyphWidth * m_glyphHeight);
+      for (unsigned i = 0u; i < m_glyphHeight; ++i)
+      {
+        memcpy(&image[i * m_glyphWidth], srcImage + ((srcY + i) * srcWidth) + srcX, m_glyphWidth * sizeof(uint8_t));
+      }
+    }
+    // Share the glyph if its image is already stored
+    _indexGlyphs();
+    const uint64_t hash = _hash(image.data(), image.size(), isMonochrome);
+    unsigned ret = 0u;
+    if (_findGlyph(hash, image.data(), isMonochrome, ret))
+    {
+      retainGlyph(ret);
+    }
+    else
+    {
+      ret = isMonochrome ? _allocateMonochrome() : _allocate();
+      memcpy(isMonochrome ? _getBits(ret) : _getImage(ret), image.data(), image.size());
+      _getReferences(ret) = 1u;
+      // On a hash collision, the glyph is stored but not shared
+      m_glyphsByHash.emplace(hash, ret);
+    }
+    return ret;
+  }
+
+  unsigned GlyphAtlas::addGlyphs(const uint8_t* const images, const unsigned count)
+  {
+    // The glyphs are appended, so their indexes are consecutive
+    const unsigned ret = getGlyphCount() | C_ALPHA_GLYPH;
+    const unsigned glyphSize = m_glyphWidth * m_glyphHeight;
+    m_blocks.resize(m_blocks.size() + (count * m_blocksPerGlyph));
+    m_references.resize(m_references.size() + count, 1u);
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      memcpy(_getImage(ret + i), images + (i * glyphSize), glyphSize);
+    }
+    // The next added glyphs can share them, they are hashed when needed
+    m_isIndexed = false;
+    return ret;
+  }
+
+  unsigned GlyphAtlas::addMonochromeGlyphs(const uint8_t* const images, const unsigned count)
+  {
+    const unsigned ret = getMonochromeGlyphCount();
+    const unsigned glyphSize = getMonochromeGlyphSize();
+    m_monochromeBlocks.resize(m_monochromeBlocks.size() + (count * m_monochromeBlocksPerGlyph));
+    m_monochromeReferences.resize(m_monochromeReferences.size() + count, 1u);
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      memcpy(_getBits(ret + i), images + (i * glyphSize), glyphSize);
+    }
+    m_isIndexed = false;
+    return ret;
+  }
+
+  void GlyphAtlas::retainGlyph(const unsigned index)
+  {
+    // The blank glyph is shared by all the fonts, and not counted
+    if (index != 0u)
+    {
+      uint32_t& references = _getReferences(index);
+      if (references > 0u)
+      {
+        ++(isMonochrome(index) ? m_sharedMonochromeReferences : m_sharedReferences);
+      }
+      ++references;
+    }
+  }
+
+  void GlyphAtlas::removeGlyph(const unsigned index)
+  {
+    if (index != 0u)
+    {
+      uint32_t& references = _getReferences(index);
+      if (references > 1u)
+      {
+        --(isMonochrome(index) ? m_sharedMonochromeReferences : m_sharedReferences);
+      }
+      --references;
+      if (references == 0u)
+      {
+        // The slot is free, its image can not be shared anymore
+        const bool isMonochromeGlyph = isMonochrome(index);
+        const uint8_t* const image = isMonochromeGlyph ? _getBits(index) : _getImage(index);
+        const unsigned size = isMonochromeGlyph ? getMonochromeGlyphSize() : (m_glyphWidth * m_glyphHeight);
+        auto iter = m_glyphsByHash.find(_hash(image, size, isMonochromeGlyph));
+        if ((iter != m_glyphsByHash.end()) && (iter->second == index))
+        {
+          m_glyphsByHash.erase(iter);
+        }
+        m_freeGlyphs.push_back(index);
+      }
+    }
+  }
+
+  void GlyphAtlas::reserve(const unsigned count, const unsigned monochromeCount)
+  {
+    m_blocks.reserve(count * m_blocksPerGlyph);
+    m_references.reserve(count);
+    m_monochromeBlocks.reserve(monochromeCount * m_monochromeBlocksPerGlyph);
+    m_monochromeReferences.reserve(monochromeCount);
+  }
+
+  // Getters
+  unsigned GlyphAtlas::getGlyphWidth(void) const
+  {
+    return m_glyphWidth;
+  }
+
+  unsigned GlyphAtlas::getGlyphHeight(void) const
+  {
+    return m_glyphHeight;
+  }
+
+  unsigned GlyphAtlas::getMonochromeGlyphSize(void) const
+  {
+    return m_bytesPerRow * m_glyphHeight;
+  }
+
+  unsigned GlyphAtlas::getGlyphCount(void) const
+  {
+    return m_blocks.size() / m_blocksPerGlyph;
+  }
+
+  unsigned GlyphAtlas::getMonochromeGlyphCount(void) const
+  {
+    return m_monochromeBlocks.size() / m_monochromeBlocksPerGlyph;
+  }
+
+  size_t GlyphAtlas::getStoredBytes(void) const
+  {
+    return (m_blocks.size() * sizeof(Block)) + (m_monochromeBlocks.size() * sizeof(MonochromeBlock));
+  }
+
+  size_t GlyphAtlas::getSharedBytes(void) const
+  {
+    return (m_sharedReferences * m_blocksPerGlyph * sizeof(Block))
+           + (m_sharedMonochromeReferences * m_monochromeBlocksPerGlyph * sizeof(MonochromeBlock));
+  }
+
+  // FNV-1a
+  uint64_t GlyphAtlas::_hash(const uint8_t* const image, const unsigned size, const bool isMonochrome)
+  {
+    uint64_t ret = isMonochrome ? 0xcbf29ce484222325ull : 0x84222325cbf29ce4ull;
+    for (unsigned i = 0u; i < size; ++i)
+    {
+      ret = (ret ^ image[i]) * 0x100000001b3ull;
+    }
+    return ret;
+  }
+
+  void GlyphAtlas::_indexGlyphs(void)
+  {
+    if (!m_isIndexed)
+    {
+      // The glyphs already indexed keep their entry
+      const unsigned glyphSize = m_glyphWidth * m_glyphHeight;
+      for (unsigned i = 0u; i < m_references.size(); ++i)
+      {
+        if (m_references[i] > 0u)
+        {
+          m_glyphsByHash.emplace(_hash(_getImage(i | C_ALPHA_GLYPH), glyphSize, false), i | C_ALPHA_GLYPH);
+        }
+      }
+      for (unsigned i = 0u; i < m_monochromeReferences.size(); ++i)
+      {
+        if (m_monochromeReferences[i] > 0u)
+        {
+          m_glyphsByHash.emplace(_hash(_getBits(i), getMonochromeGlyphSize(), true), i);
+        }
+      }
+      m_isIndexed = true;
+    }
+  }
+
+  bool GlyphAtlas::_findGlyph(const uint64_t hash, const uint8_t* const image, const bool isMonochrome,
+                              unsigned& index) const
+  {
+    bool ret = false;
+    auto iter = m_glyphsByHash.find(hash);
+    if ((iter != m_glyphsByHash.end()) && (GlyphAtlas::isMonochrome(iter->second) == isMonochrome))
+    {
+      const Glyph glyph = getGlyph(iter->second);
+      if (isMonochrome)
+      {
+        ret = memcmp(glyph.getBits(), image, getMonochromeGlyphSize()) == 0;
+      }
+      else
+      {
+        ret = memcmp(glyph.getImage(), image, m_glyphWidth * m_glyphHeight) == 0;
+      }
+    }
+    if (ret)
+    {
+      index = iter->second;
+    }
+    return ret;
+  }
+
+  bool GlyphAtlas::_isMonochrome(const uint8_t* const srcImage, const unsigned srcWidth,
+                                 const unsigned srcX, const unsigned srcY) const
+  {
+    bool ret = true;
+    for (unsigned j = 0u; (j < m_glyphHeight) && ret; ++j)
+    {
+      const uint8_t* const srcRow = srcImage + ((srcY + j) * srcWidth) + srcX;
+      for (unsigned i = 0u; (i < m_glyphWidth) && ret; ++i)
+      {
+        ret = (srcRow[i] == 0x00u) || (srcRow[i] == 0xFFu);
+      }
+    }
+    return ret;
+  }
+
+  // A removed slot of the right kind is reused first
+  unsigned GlyphAtlas::_allocate(void)
+  {
+    unsigned ret = getGlyphCount() | C_ALPHA_GLYPH;
+    bool isReused = false;
+    for (auto iter = m_freeGlyphs.begin(); iter != m_freeGlyphs.end(); ++iter)
+    {
+      if (!isMonochrome(*iter))
+      {
+        ret = *iter;
+        m_freeGlyphs.erase(iter);
+        isReused = true;
+        break;
+      }
+    }
+    if (!isReused)
+    {
+      m_blocks.resize(m_blocks.size() + m_blocksPerGlyph);
+      m_references.push_back(0u);
+    }
+    memset(_getImage(ret), 0u, m_blocksPerGlyph * C_GLYPH_ATLAS_ALIGNMENT);
+    return ret;
+  }
+
+  unsigned GlyphAtlas::_allocateMonochrome(void)
+  {
+    unsigned ret = getMonochromeGlyphCount();
+    bool isReused = false;
+    for (auto iter = m_freeGlyphs.begin(); iter != m_freeGlyphs.end(); ++iter)
+    {
+      if (isMonochrome(*iter))
+      {
+        ret = *iter;
+        m_freeGlyphs.erase(iter);
+        isReused = true;
+        break;
+      }
+    }
+    if (!isReused)
+    {
+      m_monochromeBlocks.resize(m_monochromeBlocks.size() + m_monochromeBlocksPerGlyph);
+      m_monochromeReferences.push_back(0u);
+    }
+    memset(_getBits(ret), 0u, m_monochromeBlocksPerGlyph * C_MONOCHROME_GLYPH_ALIGNMENT);
+    return ret;
+  }
+
+  uint8_t* GlyphAtlas::_getImage(const unsigned index)
+  {
+    return m_blocks[(index & ~C_ALPHA_GLYPH) * m_blocksPerGlyph].bytes;
+  }
+
+  uint8_t* GlyphAtlas::_getBits(const unsigned index)
+  {
+    return m_monochromeBlocks[index * m_monochromeBlocksPerGlyph].bytes;
+  }
+
+  uint32_t& GlyphAtlas::_getReferences(const unsigned index)
+  {
+    return isMonochrome(index) ? m_monochromeReferences[index] : m_references[index & ~C_ALPHA_GLYPH];
+  }
+
+}
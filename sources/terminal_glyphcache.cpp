@@ -0,0 +1,207 @@
+#include "terminal_glyphcache.h"
+
+namespace LRTerminal
+{
+  // Marker for the end of the LRU list
+  static const unsigned C_NO_SLOT(~0u);
+
+  ////
+  // Key
+  bool GlyphCache::Key::operator==(const Key& that) const
+  {
+    return (glyph == that.glyph) && (colors == that.colors);
+  }
+
+  size_t GlyphCache::KeyHash::operator()(const Key& key) const
+  {
+    // Mix the two halves of the key (constants from splitmix64)
+    uint64_t h = key.glyph * 0x9E3779B97F4A7C15ull;
+    h ^= key.colors + 0xBF58476D1CE4E5B9ull + (h << 6u) + (h >> 2u);
+    h ^= h >> 31u;
+    return static_cast<size_t>(h);
+  }
+
+  GlyphCache::Key GlyphCache::_makeKey(const Font font, const char32_t codePoint,
+                                       const uint32_t foreground, const uint32_t background)
+  {
+    Key key;
+    key.glyph = (static_cast<uint64_t>(codePoint) << 8u) | static_cast<uint64_t>(font);
+    key.colors = (static_cast<uint64_t>(foreground) << 32u) | background;
+    return key;
+  }
+
+  ////
+  // Glyph cache
+  // Constructor
+  GlyphCache::GlyphCache(const unsigned tileWidth, const unsigned tileHeight, const unsigned capacity):
+      m_tileWidth(tileWidth), m_tileHeight(tileHeight),
+      m_capacity(capacity > 0u ? capacity : 1u), m_size(0u),
+      m_head(C_NO_SLOT), m_tail(C_NO_SLOT),
+      m_hits(0u), m_misses(0u), m_evictions(0u)
+  {
+    m_tiles.resize(m_capacity * m_tileWidth * m_tileHeight);
+    m_keys.resize(m_capacity);
+    m_prev.resize(m_capacity, C_NO_SLOT);
+    m_next.resize(m_capacity, C_NO_SLOT);
+    m_index.reserve(m_capacity);
+  }
+
+  // Destructor
+  GlyphCache::~GlyphCache()
+  {
+    m_index.clear();
+  }
+
+  // Get the tile for a cell, or NULL if the tile is not in the cache
+  const uint32_t* GlyphCache::find(const Font font, const char32_t codePoint,
+                                   const uint32_t foreground, const uint32_t background)
+  {
+    const uint32_t* ret = NULL;
+    auto found = m_index.find(_makeKey(font, codePoint, foreground, background));
+    if (found != m_index.end())
+    {
+      const unsigned slot = found->second;
+      // Move the tile at the front of the LRU list
+      if (slot != m_head)
+      {
+        _unlink(slot);
+        _pushFront(slot);
+      }
+      ret = &m_tiles[slot * m_tileWidth * m_tileHeight];
+      ++m_hits;
+    }
+    else
+    {
+      ++m_misses;
+    }
+    return ret;
+  }
+
+  // Reserve a tile for a cell
+  uint32_t* GlyphCache::insert(const Font font, const char32_t codePoint,
+                               const uint32_t foreground, const uint32_t background)
+  {
+    const Key key = _makeKey(font, codePoint, foreground, background);
+    unsigned slot = C_NO_SLOT;
+    auto found = m_index.find(key);
+    if (found != m_index.end())
+    {
+      // Already present, the tile is overwritten
+      slot = found->second;
+      _unlink(slot);
+    }
+    else if (m_size < m_capacity)
+    {
+      // Use a free slot
+      slot = m_size;
+      ++m_size;
+      m_index.emplace(key, slot);
+    }
+    else
+    {
+      // Evict the least recently used tile
+      slot = m_tail;
+      _unlink(slot);
+      m_index.erase(m_keys[slot]);
+      m_index.emplace(key, slot);
+      ++m_evictions;
+    }
+    m_keys[slot] = key;
+    _pushFront(slot);
+    return &m_tiles[slot * m_tileWidth * m_tileHeight];
+  }
+
+  // Remove all the tiles
+  void GlyphCache::clear(void)
+  {
+    m_index.clear();
+    m_size = 0u;
+    m_head = C_NO_SLOT;
+    m_tail = C_NO_SLOT;
+  }
+
+  // Getters
+  unsigned GlyphCache::getTileWidth(void) const
+  {
+    return m_tileWidth;
+  }
+
+  unsigned GlyphCache::getTileHeight(void) const
+  {
+    return m_tileHeight;
+  }
+
+  unsigned GlyphCache::getCapacity(void) const
+  {
+    return m_capacity;
+  }
+
+  unsigned GlyphCache::getSize(void) const
+  {
+    return m_size;
+  }
+
+  // Statistics
+  uint64_t GlyphCache::getHits(void) const
+  {
+    return m_hits;
+  }
+
+  uint64_t GlyphCache::getMisses(void) const
+  {
+    return m_misses;
+  }
+
+  uint64_t GlyphCache::getEvictions(void) const
+  {
+    return m_evictions;
+  }
+
+  void GlyphCache::resetStatistics(void)
+  {
+    m_hits = 0u;
+    m_misses = 0u;
+    m_evictions = 0u;
+  }
+
+  // LRU list handling
+  void GlyphCache::_unlink(const unsigned slot)
+  {
+    const unsigned prev = m_prev[slot];
+    const unsigned next = m_next[slot];
+    if (prev != C_NO_SLOT)
+    {
+      m_next[prev] = next;
+    }
+    else
+    {
+      m_head = next;
+    }
+    if (next != C_NO_SLOT)
+    {
+      m_prev[next] = prev;
+    }
+    else
+    {
+      m_tail = prev;
+    }
+    m_prev[slot] = C_NO_SLOT;
+    m_next[slot] = C_NO_SLOT;
+  }
+
+  void GlyphCache::_pushFront(const unsigned slot)
+  {
+    m_prev[slot] = C_NO_SLOT;
+    m_next[slot] = m_head;
+    if (m_head != C_NO_SLOT)
+    {
+      m_prev[m_head] = slot;
+    }
+    m_head = slot;
+    if (m_tail == C_NO_SLOT)
+    {
+      m_tail = slot;
+    }
+  }
+
+}
@@ -4,6 +4,8 @@
 #include <cstring>
 #include <cstdio>
 #include <cstdarg>
+#include <cstdlib>
+#include <thread>
 
 namespace LRTerminal
 {
@@ -82,6 +84,17 @@ namespace LRTerminal
     { 0, 0, 0, 0, NULL },
   };
 
+  // Core options
+  static const char* const C_OPTION_RENDER_THREADS = "lrterminal_render_threads";
+  static const char* const C_OPTION_CELL_SIZE = "lrterminal_cell_size";
+
+  static const struct retro_variable C_CORE_OPTIONS[] = {
+    { C_OPTION_RENDER_THREADS, "Render threads; 1|2|3|4|6|8|auto" },
+    { C_OPTION_CELL_SIZE, "Cell size (restart); 8x16|6x12|8x8|10x20|12x24" },
+    // No more options
+    { NULL, NULL },
+  };
+
   ////
   // LibRetro class implementation
 
@@ -119,7 +132,8 @@ namespace LRTerminal
       m_supportNoGame(m_game.supportNoGame()),
       m_libraryName(m_game.getCoreName()),
       m_libraryVersion(m_game.getCoreVersion()),
-      m_validExtensions("")
+      m_validExtensions(""),
+      m_fontCacheDirectory("")
 
   {
     // Get the extension list from the core
@@ -207,12 +221,29 @@ namespace LRTerminal
        m_logCallback(RETRO_LOG_INFO, "XRGB_8888 is not supported.\n");
        return false;
     }
+    // The font files are cached in the save directory, or in the system directory
+    // The directories are only known once a game is loaded
+    const char* directory = NULL;
+    if ((_environment(RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY, &directory) && (NULL != directory))
+        || (_environment(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &directory) && (NULL != directory)))
+    {
+      m_fontCacheDirectory = directory;
+    }
     // Load the game
     bool ret = m_game.load(path);
     if (ret)
     {
       // Initialize the root console
-      m_rootConsole = new RootConsole(m_game.getTerminalWidth(),  m_game.getTerminalHeight());
+      // The size of the cells gives the size of the frames, so it only changes when a game is loaded
+      unsigned cellWidth = C_GLYPH_WIDTH;
+      unsigned cellHeight = C_GLYPH_HEIGHT;
+      _getCellSize(cellWidth, cellHeight);
+      m_rootConsole = new RootConsole(m_game.getTerminalWidth(),  m_game.getTerminalHeight(), cellWidth, cellHeight);
+      LRTerminal::log(LogLevel::INFO, "Cell size: %ux%u\n", cellWidth, cellHeight);
+      const GlyphAtlas& atlas = m_rootConsole->getBuiltinFonts().getAtlas();
+      LRTerminal::log(LogLevel::INFO, "Glyphs: %u bytes, %u bytes saved by sharing identical glyphs\n",
+                      static_cast<unsigned>(atlas.getStoredBytes()), static_cast<unsigned>(atlas.getSharedBytes()));
+      _applyCoreOptions();
       // Initialize the game
       m_game.initialize(*this);
     }
@@ -229,6 +260,11 @@ namespace LRTerminal
 
   void LibRetro::runGame(void)
   {
+    bool isOptionUpdated = false;
+    if (_environment(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &isOptionUpdated) && isOptionUpdated)
+    {
+      _applyCoreOptions();
+    }
     _inputPoll();
     m_game.update(m_deltaTime);
     unsigned width = m_rootConsole->getFontWidth() * m_game.getTerminalWidth();
@@ -239,6 +275,21 @@ namespace LRTerminal
     if (m_canDupe && (!isUpdated))
     {
       _videoRefresh(NULL, width, height, pitch);
+      return;
+    }
+    // When the frontend gives a framebuffer, the image is copied into it, so the frontend does not copy it again.
+    // Libretro does not guarantee that the content of the framebuffer persists, so the whole image is copied.
+    struct retro_framebuffer framebuffer;
+    memset(&framebuffer, 0, sizeof(framebuffer));
+    framebuffer.width = width;
+    framebuffer.height = height;
+    framebuffer.access_flags = RETRO_MEMORY_ACCESS_WRITE;
+    if (_environment(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &framebuffer) && (NULL != framebuffer.data)
+        && (framebuffer.format == RETRO_PIXEL_FORMAT_XRGB8888)
+        && (framebuffer.width == width) && (framebuffer.height == height) && (framebuffer.pitch >= pitch))
+    {
+      m_rootConsole->copyImage(static_cast<uint32_t*>(framebuffer.data), framebuffer.pitch);
+      _videoRefresh(framebuffer.data, width, height, framebuffer.pitch);
     }
     else
     {
@@ -278,6 +329,10 @@ namespace LRTerminal
 
     // Indicate if we need games
     _environment(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &m_supportNoGame);
+
+    // Declare the core options
+    _environment(RETRO_ENVIRONMENT_SET_VARIABLES,
+                 const_cast<retro_variable*>(C_CORE_OPTIONS));
   }
 
   void LibRetro::setVideoRefresh(retro_video_refresh_t& cb)
@@ -331,15 +386,31 @@ namespace LRTerminal
 
   void LibRetro::addToCustomFont(const char32_t startingCodePoint,
                                  const unsigned width, const unsigned height,
-                                 const unsigned char* const image)
+                                 const unsigned char* const image,
+                                 const unsigned glyphWidth, const unsigned glyphHeight)
   {
-    m_rootConsole->addToCustomFont(startingCodePoint, width, height, image);
+    m_rootConsole->addToCustomFont(startingCodePoint, width, height, image, glyphWidth, glyphHeight);
   }
   void LibRetro::addXBMToCustomFont(const char32_t startingCodePoint,
                                     const unsigned width, const unsigned height,
-                                    const unsigned char* const image)
+                                    const unsigned char* const image,
+                                    const unsigned glyphWidth, const unsigned glyphHeight)
   {
-    m_rootConsole->addXBMToCustomFont(startingCodePoint, width, height, image);
+    m_rootConsole->addXBMToCustomFont(startingCodePoint, width, height, image, glyphWidth, glyphHeight);
+  }
+  bool LibRetro::addFontFileToCustomFont(const char* const path)
+  {
+    FontFile::BitmapFont font;
+    const bool ret = (NULL != path) && FontFile::load(path, m_fontCacheDirectory, font);
+    if (ret)
+    {
+      m_rootConsole->addToCustomFont(font);
+    }
+    else
+    {
+      LRTerminal::log(LogLevel::ERROR, "Unable to load the font file %s\n", (NULL != path) ? path : "(null)");
+    }
+    return ret;
   }
 
   // Log
@@ -411,6 +482,45 @@ namespace LRTerminal
     }
   }
 
+  // Read the core options and apply them to the root console
+  void LibRetro::_applyCoreOptions(void)
+  {
+    struct retro_variable var;
+    var.key = C_OPTION_RENDER_THREADS;
+    var.value = NULL;
+    unsigned renderThreads = 1u;
+    if (_environment(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && (NULL != var.value))
+    {
+      if (0 == strcmp(var.value, "auto"))
+      {
+        renderThreads = std::thread::hardware_concurrency();
+      }
+      else
+      {
+        renderThreads = strtoul(var.value, NULL, 10);
+      }
+    }
+    m_rootConsole->setRenderThreads(renderThreads);
+    LRTerminal::log(LogLevel::INFO, "Render threads: %u\n", m_rootConsole->getRenderThreads());
+  }
+
+  // Read the cell size core option, the size is not changed if the option is not set
+  void LibRetro::_getCellSize(unsigned& width, unsigned& height)
+  {
+    struct retro_variable var;
+    var.key = C_OPTION_CELL_SIZE;
+    var.value = NULL;
+    unsigned optionWidth = 0u;
+    unsigned optionHeight = 0u;
+    if (_environment(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && (NULL != var.value)
+        && (2 == sscanf(var.value, "%ux%u", &optionWidth, &optionHeight))
+        && (optionWidth > 0u) && (optionHeight > 0u))
+    {
+      width = optionWidth;
+      height = optionHeight;
+    }
+  }
+
   // This method is static because of the LibRetro interface
   void LibRetro::_timeCallback(retro_usec_t usec)
   {
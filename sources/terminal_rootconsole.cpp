@@ -1,16 +1,32 @@
 #include "terminal_rootconsole.h"
+#include "terminal_blend.h"
+#include "terminal_utils.h"
+#include <cstring>
+#include <algorithm>
 
 namespace LRTerminal
 {
+  // Code point used for cells that have never been rendered
+  static const char32_t C_INVALID_CODE_POINT(0xFFFFFFFFu);
+
   // Constructor
-  RootConsole::RootConsole(const unsigned width, const unsigned height): Console(width, height)
+  RootConsole::RootConsole(const unsigned width, const unsigned height,
+                           const unsigned cellWidth, const unsigned cellHeight):
+      Console(width, height), m_cellWidth(cellWidth), m_cellHeight(cellHeight),
+      m_renderRows(_getRenderRowsFunction(cellWidth, cellHeight)),
+      m_builtinFonts(cellWidth, cellHeight), m_workerPool(NULL)
   {
-    m_framebuffer = new uint32_t[width * C_GLYPH_WIDTH * height * C_GLYPH_HEIGHT];
+    m_framebuffer = new uint32_t[width * cellWidth * height * cellHeight];
+    m_renderedCells.resize(width * height);
+    m_isScrolled = false;
+    setRenderThreads(1u);
+    _invalidateRenderedCells();
   }
 
   // Destructor
   RootConsole::~RootConsole()
   {
+    delete m_workerPool;
     delete[] m_framebuffer;
   }
 
@@ -18,68 +34,260 @@ namespace LRTerminal
   // Each unsigned represents a pixel in the XRGB_8888 format
   const uint32_t* RootConsole::renderImage(bool& isUpdated)
   {
-    isUpdated = false;
-    const unsigned consoleHeight = getHeight();
-    const unsigned consoleWidth = getWidth();
-    //
-    for (unsigned ch = 0u; ch < consoleHeight; ++ch)
+    // The moved pixels are a change of the image, even if no cell is rendered
+    isUpdated = m_isScrolled;
+    m_isScrolled = false;
+    DirtyTracker& dirtyCells = _getDirtyCells();
+    if (!dirtyCells.isEmpty())
     {
-      for (unsigned cw = 0u; cw < consoleWidth; ++cw)
+      const unsigned consoleHeight = getHeight();
+      const unsigned bandCount = m_glyphCaches.size();
+      if (m_workerPool == NULL)
       {
-        // Only render the cell that have been modified
-        if (_isDirty(cw, ch))
+        isUpdated = (this->*m_renderRows)(0u, consoleHeight, m_glyphCaches[0u]) || isUpdated;
+      }
+      else
+      {
+        // Each band only writes its own cells and pixels, so the bands need no locking
+        m_workerPool->run(bandCount, [this, consoleHeight, bandCount](const unsigned band) {
+          const unsigned firstRow = (band * consoleHeight) / bandCount;
+          const unsigned lastRow = ((band + 1u) * consoleHeight) / bandCount;
+          m_isBandUpdated[band] = (this->*m_renderRows)(firstRow, lastRow, m_glyphCaches[band]);
+        });
+        for (unsigned band = 0u; band < bandCount; ++band)
         {
-          // Draw a cell into the framebuffer
-          const Glyph& glyph = m_builtinFonts.getGlyph(getFont(cw, ch), getChar(cw, ch));
-          const Color& backColor = getBackground(cw, ch);
-          const Color& foreColor = getForeground(cw, ch);
-          const unsigned glyphHeight = glyph.getHeight();
-          const unsigned glyphWidth = glyph.getWidth();
-          const uint8_t* const image = glyph.getImage();
-          //
-          for (unsigned j = 0u; j < glyphHeight; ++j)
-          {
-            for (unsigned i = 0u; i < glyphWidth; ++i)
-            {
-              Color col = Color::lerp(backColor, foreColor,
-                                      static_cast<float>(image[i + j * glyphWidth]) / 255.0f);
-              unsigned idx = ((ch * glyphHeight + j) * consoleWidth * glyphWidth) + (cw * glyphWidth + i);
-              //
-              m_framebuffer[idx] = col.toXRGB();
-            }
-          }
-          _unsetDirty(cw, ch);
-          isUpdated = true;
+          isUpdated = isUpdated || (m_isBandUpdated[band] != 0u);
         }
       }
+      // All the rows are clean now
+      dirtyCells.clearRowSummary();
     }
     return m_framebuffer;
   }
 
+  // Copy the rendered image into another buffer
+  void RootConsole::copyImage(uint32_t* const target, const size_t pitch) const
+  {
+    // Nothing is known of the content of the buffer, the whole image is copied
+    const size_t rowSize = getWidth() * m_cellWidth * sizeof(uint32_t);
+    const unsigned imageHeight = getHeight() * m_cellHeight;
+    if (pitch == rowSize)
+    {
+      memcpy(target, m_framebuffer, rowSize * imageHeight);
+      return;
+    }
+    for (unsigned j = 0u; j < imageHeight; ++j)
+    {
+      memcpy(reinterpret_cast<uint8_t*>(target) + (j * pitch),
+             reinterpret_cast<const uint8_t*>(m_framebuffer) + (j * rowSize), rowSize);
+    }
+  }
+
+  // Version of _renderRows for a cell size
+  RootConsole::RenderRowsFunction RootConsole::_getRenderRowsFunction(const unsigned cellWidth, const unsigned cellHeight)
+  {
+    // The cell sizes of the core option
+    if ((cellWidth == 8u) && (cellHeight == 16u))
+    {
+      return &RootConsole::_renderRows<8u, 16u>;
+    }
+    if ((cellWidth == 6u) && (cellHeight == 12u))
+    {
+      return &RootConsole::_renderRows<6u, 12u>;
+    }
+    if ((cellWidth == 8u) && (cellHeight == 8u))
+    {
+      return &RootConsole::_renderRows<8u, 8u>;
+    }
+    if ((cellWidth == 10u) && (cellHeight == 20u))
+    {
+      return &RootConsole::_renderRows<10u, 20u>;
+    }
+    if ((cellWidth == 12u) && (cellHeight == 24u))
+    {
+      return &RootConsole::_renderRows<12u, 24u>;
+    }
+    return &RootConsole::_renderRows<0u, 0u>;
+  }
+
+  // Render the dirty cells of the rows [firstRow; lastRow[
+  // With a constant cell size, the copies of the rows of a tile are unrolled into fixed size moves
+  template <unsigned CellWidth, unsigned CellHeight>
+  bool RootConsole::_renderRows(const unsigned firstRow, const unsigned lastRow, GlyphCache& glyphCache)
+  {
+    bool ret = false;
+    DirtyTracker& dirtyCells = _getDirtyCells();
+    const unsigned consoleWidth = getWidth();
+    const unsigned glyphHeight = (CellHeight != 0u) ? CellHeight : m_cellHeight;
+    const unsigned glyphWidth = (CellWidth != 0u) ? CellWidth : m_cellWidth;
+    // The dirty cells are enumerated row by row
+    unsigned row = lastRow;
+    CellSpan cells;
+    // Only render the cells that have been modified
+    dirtyCells.forEachDirtyCell(firstRow, lastRow, [&](const unsigned cw, const unsigned ch) {
+      if (ch != row)
+      {
+        row = ch;
+        cells = _getRowCells(row);
+      }
+      const unsigned index = (ch * consoleWidth) + cw;
+      const Font font = static_cast<Font>(cells.fonts[cw]);
+      const char32_t codePoint = cells.codePoints[cw];
+      const uint32_t foreground = cells.foregrounds[cw];
+      const uint32_t background = cells.backgrounds[cw];
+      // A cell may have been modified and then set back to its previous content,
+      // for example when the console is cleared and redrawn at each frame
+      RenderedCell& rendered = m_renderedCells[index];
+      if ((rendered.codePoint == codePoint) && (rendered.font == font) &&
+          (rendered.foreground == foreground) && (rendered.background == background))
+      {
+        return;
+      }
+      rendered.codePoint = codePoint;
+      rendered.font = font;
+      rendered.foreground = foreground;
+      rendered.background = background;
+      // Draw a cell into the framebuffer
+      // Blend the glyph only if it is not already in the cache
+      const uint32_t* tile = glyphCache.find(font, codePoint, foreground, background);
+      if (tile == NULL)
+      {
+        const Glyph glyph = m_builtinFonts.getGlyph(font, codePoint);
+        uint32_t* newTile = glyphCache.insert(font, codePoint, foreground, background);
+        // The monochrome glyphs only need a choice between the two colors
+        if (glyph.isMonochrome())
+        {
+          Blend::selectRows(glyph.getBits(), glyphWidth, glyphHeight,
+                            Color::fromXRGB(background), Color::fromXRGB(foreground), newTile);
+        }
+        else
+        {
+          Blend::blendRow(glyph.getImage(), glyphWidth * glyphHeight,
+                          Color::fromXRGB(background), Color::fromXRGB(foreground), newTile);
+        }
+        tile = newTile;
+      }
+      // Copy the tile
+      for (unsigned j = 0u; j < glyphHeight; ++j)
+      {
+        unsigned idx = ((ch * glyphHeight + j) * consoleWidth * glyphWidth) + (cw * glyphWidth);
+        memcpy(&m_framebuffer[idx], &tile[j * glyphWidth], glyphWidth * sizeof(uint32_t));
+      }
+      ret = true;
+    });
+    dirtyCells.clearRows(firstRow, lastRow);
+    return ret;
+  }
+
+  // Scrolling
+  void RootConsole::_onScroll(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1,
+                              const int dx, const int dy)
+  {
+    // The rendered cells describe the framebuffer, they are moved along with the pixels
+    const unsigned glyphWidth = m_cellWidth;
+    const unsigned glyphHeight = m_cellHeight;
+    Utils::moveRect(m_renderedCells.data(), getWidth(), x0, y0, x1, y1, dx, dy);
+    m_isScrolled = true;
+    Utils::moveRect(m_framebuffer, getWidth() * glyphWidth,
+                    x0 * glyphWidth, y0 * glyphHeight, x1 * glyphWidth, y1 * glyphHeight,
+                    dx * static_cast<int>(glyphWidth), dy * static_cast<int>(glyphHeight));
+  }
+
+  // Number of threads used for rendering
+  void RootConsole::setRenderThreads(const unsigned threadCount)
+  {
+    // At least one band, and no band without rows
+    unsigned bandCount = std::max(threadCount, 1u);
+    bandCount = std::min(bandCount, std::max(getHeight(), 1u));
+    if (bandCount != m_glyphCaches.size())
+    {
+      delete m_workerPool;
+      m_workerPool = NULL;
+      if (bandCount > 1u)
+      {
+        m_workerPool = new WorkerPool(bandCount);
+      }
+      // Each band has its own cache, so the bands share no mutable state
+      m_glyphCaches.clear();
+      m_glyphCaches.reserve(bandCount);
+      for (unsigned band = 0u; band < bandCount; ++band)
+      {
+        m_glyphCaches.emplace_back(m_cellWidth, m_cellHeight);
+      }
+      m_isBandUpdated.assign(bandCount, 0u);
+    }
+  }
+
+  unsigned RootConsole::getRenderThreads(void) const
+  {
+    return m_glyphCaches.size();
+  }
+
   // Get Font width & height
   const unsigned RootConsole::getFontWidth(void) const
   {
-    return C_GLYPH_WIDTH;
+    return m_cellWidth;
   }
 
   const unsigned RootConsole::getFontHeight(void) const
   {
-    return C_GLYPH_HEIGHT;
+    return m_cellHeight;
+  }
+
+
+  // Caches of the rendered glyphs
+  unsigned RootConsole::getGlyphCacheCount(void) const
+  {
+    return m_glyphCaches.size();
   }
 
+  const GlyphCache& RootConsole::getGlyphCache(const unsigned band) const
+  {
+    return m_glyphCaches.at(band);
+  }
+
+  const BuiltinFonts& RootConsole::getBuiltinFonts(void) const
+  {
+    return m_builtinFonts;
+  }
 
   void RootConsole::addToCustomFont(const char32_t startingCodePoint,
                                     const unsigned width, const unsigned height,
-                                    const unsigned char* const image)
+                                    const unsigned char* const image,
+                                    const unsigned glyphWidth, const unsigned glyphHeight)
   {
-    m_builtinFonts.addToCustomFont(startingCodePoint, width, height, image);
+    m_builtinFonts.addToCustomFont(startingCodePoint, width, height, image, glyphWidth, glyphHeight);
+    // The tiles and cells using the replaced glyphs are not valid anymore
+    _invalidateRenderedCells();
   }
 
   void RootConsole::addXBMToCustomFont(const char32_t startingCodePoint,
                                        const unsigned width, const unsigned height,
-                                       const unsigned char* const image)
+                                       const unsigned char* const image,
+                                       const unsigned glyphWidth, const unsigned glyphHeight)
   {
-    m_builtinFonts.addXBMToCustomFont(startingCodePoint, width, height, image);
+    m_builtinFonts.addXBMToCustomFont(startingCodePoint, width, height, image, glyphWidth, glyphHeight);
+    // The tiles and cells using the replaced glyphs are not valid anymore
+    _invalidateRenderedCells();
+  }
+
+  void RootConsole::addToCustomFont(const FontFile::BitmapFont& font)
+  {
+    m_builtinFonts.addToCustomFont(font);
+    // The tiles and cells using the replaced glyphs are not valid anymore
+    _invalidateRenderedCells();
+  }
+
+  void RootConsole::_invalidateRenderedCells(void)
+  {
+    for (auto iter = m_glyphCaches.begin(); iter != m_glyphCaches.end(); ++iter)
+    {
+      iter->clear();
+    }
+    // No cell has an invalid code point, so none will match
+    const RenderedCell invalidCell = { C_INVALID_CODE_POINT, 0u, 0u, Font::DEFAULT };
+    std::fill(m_renderedCells.begin(), m_renderedCells.end(), invalidCell);
+    _getDirtyCells().markAll();
   }
 
 }
@@ -0,0 +1,125 @@
+#include "terminal_textlayout.h"
+
+namespace LRTerminal
+{
+  ////
+  // Line breaker
+  LineBreaker::LineBreaker(const std::u32string_view text, const unsigned width):
+      m_text(text), m_width(width), m_position(0u)
+  {
+    // An empty text has no line
+    if (text.empty())
+    {
+      m_position = 1u;
+    }
+  }
+
+  bool LineBreaker::next(TextLine& line)
+  {
+    if (m_position > m_text.size())
+    {
+      return false;
+    }
+    line.start = m_position;
+    line.length = 0u;
+    bool isEmpty = true;
+    while (m_position <= m_text.size())
+    {
+      const size_t nextSpace = m_text.find(U' ', m_position);
+      const size_t wordEnd = (nextSpace == std::u32string_view::npos) ? m_text.size() : nextSpace;
+      // The word does not fit, it starts the next line
+      if (!isEmpty && ((line.length + 1u + (wordEnd - m_position)) >= m_width))
+      {
+        break;
+      }
+      line.length = wordEnd - line.start;
+      isEmpty = false;
+      // Skip the space after the word, or go past the end of the text after the last word
+      m_position = wordEnd + 1u;
+    }
+    return true;
+  }
+
+  ////
+  // Text layout cache
+  // Constructor
+  TextLayoutCache::TextLayoutCache(const unsigned capacity):
+      m_capacity(capacity > 0u ? capacity : 1u), m_useCounter(0u), m_hits(0u), m_misses(0u)
+  {
+  }
+
+  const std::vector<TextLine>& TextLayoutCache::getLines(const std::u32string_view text, const unsigned width)
+  {
+    // The consoles which do not print wrapped texts have no entries
+    if (m_entries.empty())
+    {
+      m_entries.resize(m_capacity);
+    }
+    const uint64_t hash = _hash(text);
+    ++m_useCounter;
+    // Look for the layout, and for the least recently used entry in case it is missing
+    Entry* oldest = &m_entries.front();
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+      if ( (iter->lastUse != 0u) && (iter->hash == hash) && (iter->width == width)
+        && (iter->text == text))
+      {
+        ++m_hits;
+        iter->lastUse = m_useCounter;
+        return iter->lines;
+      }
+      if (iter->lastUse < oldest->lastUse)
+      {
+        oldest = &*iter;
+      }
+    }
+    // Wrap the text into the replaced entry
+    ++m_misses;
+    oldest->hash = hash;
+    oldest->width = width;
+    oldest->lastUse = m_useCounter;
+    oldest->text.assign(text);
+    oldest->lines.clear();
+    LineBreaker breaker(text, width);
+    TextLine line;
+    while (breaker.next(line))
+    {
+      oldest->lines.push_back(line);
+    }
+    return oldest->lines;
+  }
+
+  void TextLayoutCache::clear(void)
+  {
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+      iter->hash = 0u;
+      iter->width = 0u;
+      iter->lastUse = 0u;
+      iter->text.clear();
+      iter->lines.clear();
+    }
+  }
+
+  uint64_t TextLayoutCache::getHits(void) const
+  {
+    return m_hits;
+  }
+
+  uint64_t TextLayoutCache::getMisses(void) const
+  {
+    return m_misses;
+  }
+
+  // FNV-1a over the code points
+  uint64_t TextLayoutCache::_hash(const std::u32string_view text)
+  {
+    uint64_t ret = 0xCBF29CE484222325ull;
+    for (auto iter = text.begin(); iter != text.end(); ++iter)
+    {
+      ret = (ret ^ static_cast<uint64_t>(*iter)) * 0x100000001B3ull;
+    }
+    return ret;
+  }
+
+}
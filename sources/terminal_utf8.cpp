@@ -0,0 +1,126 @@
+#include "terminal_utf8.h"
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace LRTerminal::Utf8
+{
+  // Number of bytes at the start of a string that are ASCII characters
+  size_t getAsciiLength(const char* const str, const size_t size)
+  {
+    size_t ret = 0u;
+#ifdef __SSE2__
+    // 16 bytes by iteration: the mask has a bit set for each byte with its high bit set
+    for (; ret + 16u <= size; ret += 16u)
+    {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + ret));
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+      if (mask != 0u)
+      {
+        return ret + __builtin_ctz(mask);
+      }
+    }
+#else
+    // 8 bytes by iteration
+    for (; ret + 8u <= size; ret += 8u)
+    {
+      uint64_t bytes = 0u;
+      memcpy(&bytes, str + ret, sizeof(bytes));
+      if ((bytes & UINT64_C(0x8080808080808080)) != 0u)
+      {
+        break;
+      }
+    }
+#endif
+    while ((ret < size) && ((static_cast<uint8_t>(str[ret]) & 0x80u) == 0u))
+    {
+      ++ret;
+    }
+    return ret;
+  }
+
+  // Decode the code point starting at it
+  char32_t decode(const char*& it, const char* const end)
+  {
+    const uint8_t first = static_cast<uint8_t>(*it++);
+    if (first < 0x80u)
+    {
+      return first;
+    }
+    // Number of continuation bytes and range of the second byte,
+    // which excludes the overlong forms, the surrogates and the values above U+10FFFF
+    unsigned count = 0u;
+    uint8_t low = 0x80u;
+    uint8_t high = 0xBFu;
+    char32_t ret = 0u;
+    if ((first >= 0xC2u) && (first <= 0xDFu))
+    {
+      count = 1u;
+      ret = first & 0x1Fu;
+    }
+    else if ((first >= 0xE0u) && (first <= 0xEFu))
+    {
+      count = 2u;
+      ret = first & 0x0Fu;
+      low = (first == 0xE0u) ? 0xA0u : 0x80u;
+      high = (first == 0xEDu) ? 0x9Fu : 0xBFu;
+    }
+    else if ((first >= 0xF0u) && (first <= 0xF4u))
+    {
+      count = 3u;
+      ret = first & 0x07u;
+      low = (first == 0xF0u) ? 0x90u : 0x80u;
+      high = (first == 0xF4u) ? 0x8Fu : 0xBFu;
+    }
+    else
+    {
+      // Continuation byte or invalid leading byte
+      return C_REPLACEMENT_CHARACTER;
+    }
+    for (unsigned i = 0u; i < count; ++i)
+    {
+      // The invalid byte is not consumed, it may start the next sequence
+      if ((it == end) || (static_cast<uint8_t>(*it) < low) || (static_cast<uint8_t>(*it) > high))
+      {
+        return C_REPLACEMENT_CHARACTER;
+      }
+      ret = (ret << 6) | (static_cast<uint8_t>(*it++) & 0x3Fu);
+      low = 0x80u;
+      high = 0xBFu;
+    }
+    return ret;
+  }
+
+  // Number of code points of a string
+  size_t getLength(const char* const str, const size_t size)
+  {
+    size_t ret = 0u;
+    const char* it = str;
+    const char* const end = str + size;
+    while (it != end)
+    {
+      const size_t asciiLength = getAsciiLength(it, end - it);
+      it += asciiLength;
+      ret += asciiLength;
+      if (it != end)
+      {
+        (void)decode(it, end);
+        ++ret;
+      }
+    }
+    return ret;
+  }
+
+  // Decode a string
+  void decode(const char* const str, const size_t size, std::u32string& out)
+  {
+    out.clear();
+    forEachCodePoint(str, size, [&out](const char32_t codePoint) {
+      out.push_back(codePoint);
+    });
+  }
+
+}
@@ -0,0 +1,104 @@
+#include "terminal_workerpool.h"
+
+namespace LRTerminal
+{
+  // Constructor
+  WorkerPool::WorkerPool(const unsigned threadCount):
+      m_job(NULL), m_jobCount(0u), m_nextJob(0u),
+      m_busyWorkers(0u), m_generation(0u), m_isStopping(false)
+  {
+    for (unsigned i = 1u; i < threadCount; ++i)
+    {
+      m_workers.emplace_back(&WorkerPool::_workerLoop, this);
+    }
+  }
+
+  // Destructor
+  WorkerPool::~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isStopping = true;
+    }
+    m_startCondition.notify_all();
+    for (auto iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+    {
+      iter->join();
+    }
+  }
+
+  unsigned WorkerPool::getThreadCount(void) const
+  {
+    return m_workers.size() + 1u;
+  }
+
+  // Execute the jobs and wait for them to be done
+  void WorkerPool::run(const unsigned jobCount, const std::function<void(const unsigned)>& job)
+  {
+    if (m_workers.empty() || (jobCount <= 1u))
+    {
+      // No need to wake up the workers
+      for (unsigned i = 0u; i < jobCount; ++i)
+      {
+        job(i);
+      }
+    }
+    else
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_jobCount = jobCount;
+        m_nextJob.store(0u);
+        m_busyWorkers = m_workers.size();
+        ++m_generation;
+      }
+      m_startCondition.notify_all();
+      // The calling thread takes part in the work
+      _executeJobs();
+      // Wait for the workers
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0u; });
+      m_job = NULL;
+    }
+  }
+
+  void WorkerPool::_workerLoop(void)
+  {
+    uint64_t lastGeneration = 0u;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_startCondition.wait(lock, [this, lastGeneration] {
+          return m_isStopping || (m_generation != lastGeneration);
+        });
+        if (m_isStopping)
+        {
+          break;
+        }
+        lastGeneration = m_generation;
+      }
+      _executeJobs();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_busyWorkers;
+        if (m_busyWorkers == 0u)
+        {
+          m_doneCondition.notify_one();
+        }
+      }
+    }
+  }
+
+  void WorkerPool::_executeJobs(void)
+  {
+    unsigned index = m_nextJob.fetch_add(1u);
+    while (index < m_jobCount)
+    {
+      (*m_job)(index);
+      index = m_nextJob.fetch_add(1u);
+    }
+  }
+
+}
@@ -4,6 +4,8 @@
 #include "terminal_color.h"
 #include "terminal_textstyle.h"
 #include "terminal_console.h"
+#include "terminal_consoleview.h"
+#include "terminal_drawlist.h"
 #include "terminal_terminal.h"
 #include "terminal_log.h"
 %}
@@ -11,6 +13,8 @@
 %include "terminal_color.h"
 %include "terminal_textstyle.h"
 %include "terminal_console.h"
+%include "terminal_consoleview.h"
+%include "terminal_drawlist.h"
 %include "terminal_terminal.h"
 %include "terminal_log.h"
 
@@ -28,22 +32,15 @@ LRTerminal::Terminal* terminal();
 
 /* A way to easily convert a char* to a single char32_t */
 %{
-#include <locale>
-#include <codecvt>
-std::u32string _stringToU32String(const std::string str)
-{
-  // Convert from utf-8 char* to utf-32 char32_t* in order to update the console cells
-  std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> u32conv;
-  return u32conv.from_bytes(str);
-}
+#include "terminal_utf8.h"
+#include <cstring>
 char32_t codePoint(const char* in)
 {
     char32_t ret = U'\0';
-    std::string strIn = in;
-    if (strIn != "")
+    if ((in != NULL) && (in[0] != '\0'))
     {
-      std::u32string strU32 = _stringToU32String(std::string(in));
-      ret = strU32[0];
+      const char* it = in;
+      ret = LRTerminal::Utf8::decode(it, in + strlen(in));
     }
     return ret;
 }
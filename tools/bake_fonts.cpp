@@ -0,0 +1,243 @@
+// Font baker
+// Decodes the XBM images of the builtin fonts (ressources/fonts/*/font.inc) at build time,
+// and writes the glyphs as packed monochrome images, ready to be copied into a GlyphAtlas.
+// The images are also written scaled to each cell size of the "Cell size" core option.
+// Usage: bake_fonts > ressources/fonts/baked_fonts.inc
+#include "terminal_fontfile.h"
+#include "terminal_glyphatlas.h"
+#include "terminal_textstyle.h"
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace LRTerminal
+{
+  // Size of the glyphs, written as s_bakedGlyphWidth and s_bakedGlyphHeight and as the first entry of s_bakedSizes,
+  // both are checked against C_GLYPH_WIDTH and C_GLYPH_HEIGHT by static_asserts in terminal_builtin_fonts.cpp
+  const unsigned C_BAKED_GLYPH_WIDTH(8u);
+  const unsigned C_BAKED_GLYPH_HEIGHT(16u);
+  const unsigned C_BAKED_BYTES_PER_ROW((C_BAKED_GLYPH_WIDTH + 7u) / 8u);
+  const unsigned C_BAKED_GLYPH_SIZE(C_BAKED_BYTES_PER_ROW * C_BAKED_GLYPH_HEIGHT);
+  // Size of a glyph in a GlyphAtlas, the monochrome images are padded to C_MONOCHROME_GLYPH_ALIGNMENT
+  const unsigned C_ATLAS_GLYPH_SIZE(((C_BAKED_GLYPH_SIZE + C_MONOCHROME_GLYPH_ALIGNMENT - 1u) / C_MONOCHROME_GLYPH_ALIGNMENT)
+                                    * C_MONOCHROME_GLYPH_ALIGNMENT);
+  const unsigned C_FONT_COUNT(static_cast<unsigned>(Font::CUSTOM));
+  // Cell sizes of the core option (see C_OPTION_CELL_SIZE) other than the size of the glyphs
+  const unsigned C_SCALED_SIZES[][2] = { {6u, 12u}, {8u, 8u}, {10u, 20u}, {12u, 24u} };
+
+  // Stand-in for the builtin fonts, the font.inc files call loadXbmFont on it
+  // The glyphs are added like FontData::addGlyphs does: a glyph replaces the previous one at its code point,
+  // and the blank glyphs are not stored.
+  class BuiltinFonts
+  {
+  public:
+    typedef std::vector<uint8_t> GlyphBits;
+
+    void loadXbmFont(const Font font, const char32_t startingCodePoint,
+                     const unsigned imageWidth, const unsigned imageHeight,
+                     const unsigned char* const imageXbm)
+    {
+      std::map<char32_t, GlyphBits>& glyphs = m_fonts[static_cast<unsigned>(font)];
+      // Each byte of the image represents a block of eight horizontal pixels, zero-padded at the end of a row
+      const unsigned xbmWidth = (imageWidth + 7u) / 8u;
+      const unsigned nbGlyphsW = imageWidth / C_BAKED_GLYPH_WIDTH;
+      const unsigned nbGlyphsH = imageHeight / C_BAKED_GLYPH_HEIGHT;
+      for (unsigned j = 0u; j < nbGlyphsH; ++j)
+      {
+        for (unsigned i = 0u; i < nbGlyphsW; ++i)
+        {
+          const char32_t codePoint = startingCodePoint + (j * nbGlyphsW) + i;
+          // The code point 0 is the blank glyph
+          if (codePoint == 0u)
+          {
+            continue;
+          }
+          GlyphBits bits(C_BAKED_GLYPH_SIZE, 0u);
+          bool isBlank = true;
+          for (unsigned y = 0u; y < C_BAKED_GLYPH_HEIGHT; ++y)
+          {
+            for (unsigned x = 0u; x < C_BAKED_GLYPH_WIDTH; ++x)
+            {
+              // The order of the pixels is little endian, like in the atlas
+              const unsigned srcX = (i * C_BAKED_GLYPH_WIDTH) + x;
+              const unsigned srcY = (j * C_BAKED_GLYPH_HEIGHT) + y;
+              if ((imageXbm[(srcY * xbmWidth) + (srcX / 8u)] >> (srcX % 8u)) & 1u)
+              {
+                bits[(y * C_BAKED_BYTES_PER_ROW) + (x / 8u)] |= 1u << (x % 8u);
+                isBlank = false;
+              }
+            }
+          }
+          if (isBlank)
+          {
+            glyphs.erase(codePoint);
+          }
+          else
+          {
+            glyphs[codePoint] = bits;
+          }
+        }
+      }
+    }
+
+    // Write the glyphs as a C++ source, see BuiltinFonts::BuiltinFonts
+    // The identical glyphs, of the same font or of different fonts, are written once.
+    void write(FILE* const file) const
+    {
+      // Unique images, in the order of their first use
+      std::map<GlyphBits, unsigned> uniqueGlyphs;
+      std::vector<const GlyphBits*> images;
+      unsigned glyphCount = 0u;
+      for (unsigned font = 0u; font < C_FONT_COUNT; ++font)
+      {
+        for (auto iter = m_fonts[font].begin(); iter != m_fonts[font].end(); ++iter)
+        {
+          auto unique = uniqueGlyphs.emplace(iter->second, images.size());
+          if (unique.second)
+          {
+            images.push_back(&unique.first->first);
+          }
+          ++glyphCount;
+        }
+      }
+      fprintf(file, "// Generated by tools/bake_fonts.cpp from ressources/fonts, do not edit\n");
+      fprintf(file, "// %u glyphs, %u unique images: %u bytes in the glyph atlas instead of %u\n",
+              glyphCount, static_cast<unsigned>(images.size()),
+              static_cast<unsigned>(images.size()) * C_ATLAS_GLYPH_SIZE, glyphCount * C_ATLAS_GLYPH_SIZE);
+      fprintf(file, "static const unsigned s_bakedGlyphWidth = %uu;\n", C_BAKED_GLYPH_WIDTH);
+      fprintf(file, "static const unsigned s_bakedGlyphHeight = %uu;\n", C_BAKED_GLYPH_HEIGHT);
+      // Glyphs of each font, in the order of the fonts
+      fprintf(file, "static const BakedFont s_bakedFonts[] = {\n");
+      unsigned first = 0u;
+      for (unsigned font = 0u; font < C_FONT_COUNT; ++font)
+      {
+        fprintf(file, "  {static_cast<Font>(%u), %uu, %uu},\n", font, first, static_cast<unsigned>(m_fonts[font].size()));
+        first += m_fonts[font].size();
+      }
+      fprintf(file, "};\n");
+      // Code points of the glyphs, and index of their image
+      fprintf(file, "static const char32_t s_bakedCodePoints[] = {");
+      unsigned count = 0u;
+      for (unsigned font = 0u; font < C_FONT_COUNT; ++font)
+      {
+        for (auto iter = m_fonts[font].begin(); iter != m_fonts[font].end(); ++iter)
+        {
+          fprintf(file, "%s0x%06Xu,", ((count++ % 8u) == 0u) ? "\n  " : " ", static_cast<unsigned>(iter->first));
+        }
+      }
+      fprintf(file, "\n};\n");
+      fprintf(file, "static const unsigned s_bakedGlyphIndexes[] = {");
+      count = 0u;
+      for (unsigned font = 0u; font < C_FONT_COUNT; ++font)
+      {
+        for (auto iter = m_fonts[font].begin(); iter != m_fonts[font].end(); ++iter)
+        {
+          fprintf(file, "%s%uu,", ((count++ % 12u) == 0u) ? "\n  " : " ", uniqueGlyphs.at(iter->second));
+        }
+      }
+      fprintf(file, "\n};\n");
+      // Monochrome images of the glyphs, one after another
+      std::vector<uint8_t> bits;
+      for (auto image = images.begin(); image != images.end(); ++image)
+      {
+        bits.insert(bits.end(), (*image)->begin(), (*image)->end());
+      }
+      _writeBits(file, "s_bakedGlyphBits", bits);
+      fprintf(file, "static const unsigned s_bakedImageCount = %uu;\n", static_cast<unsigned>(images.size()));
+      // The same images at the other cell sizes, the glyphs have the same indexes
+      unsigned scaledBytes = 0u;
+      for (const auto& size : C_SCALED_SIZES)
+      {
+        std::vector<uint8_t> scaledBits;
+        FontFile::scaleImages(bits.data(), images.size(), C_BAKED_GLYPH_WIDTH, C_BAKED_GLYPH_HEIGHT,
+                              size[0], size[1], scaledBits);
+        char name[64];
+        snprintf(name, sizeof(name), "s_bakedGlyphBits%ux%u", size[0], size[1]);
+        _writeBits(file, name, scaledBits);
+        scaledBytes += scaledBits.size();
+      }
+      fprintf(file, "static constexpr BakedSize s_bakedSizes[] = {\n");
+      fprintf(file, "  {%uu, %uu, s_bakedGlyphBits},\n", C_BAKED_GLYPH_WIDTH, C_BAKED_GLYPH_HEIGHT);
+      for (const auto& size : C_SCALED_SIZES)
+      {
+        fprintf(file, "  {%uu, %uu, s_bakedGlyphBits%ux%u},\n", size[0], size[1], size[0], size[1]);
+      }
+      fprintf(file, "};\n");
+      // Summary on the build output
+      // The bytes saved are counted as GlyphAtlas::getSharedBytes does, at the size of the baked glyphs
+      fprintf(stderr, "bake_fonts: %u glyphs, %u unique images, %u atlas bytes saved, %u bytes of scaled images\n",
+              glyphCount, static_cast<unsigned>(images.size()),
+              (glyphCount - static_cast<unsigned>(images.size())) * C_ATLAS_GLYPH_SIZE, scaledBytes);
+    }
+
+  private:
+    // Write an array of bytes
+    static void _writeBits(FILE* const file, const char* const name, const std::vector<uint8_t>& bits)
+    {
+      fprintf(file, "alignas(16) static const uint8_t %s[] = {", name);
+      unsigned count = 0u;
+      for (auto byte = bits.begin(); byte != bits.end(); ++byte)
+      {
+        fprintf(file, "%s0x%02X,", ((count++ % 16u) == 0u) ? "\n  " : " ", static_cast<unsigned>(*byte));
+      }
+      fprintf(file, "\n};\n");
+    }
+
+    std::map<char32_t, GlyphBits> m_fonts[C_FONT_COUNT];
+  };
+
+  namespace Fonts::Default
+  {
+#include "fonts/default/font.inc"
+  }
+  namespace Fonts::TamsynR
+  {
+#include "fonts/TamsynR/font.inc"
+  }
+  namespace Fonts::TamsynB
+  {
+#include "fonts/TamsynB/font.inc"
+  }
+  namespace Fonts::SonyMisc8x16
+  {
+#include "fonts/8x16/font.inc"
+  }
+  namespace Fonts::MiscMisc8x13
+  {
+#include "fonts/8x13/font.inc"
+  }
+  namespace Fonts::MiscMisc8x13B
+  {
+#include "fonts/8x13B/font.inc"
+  }
+  namespace Fonts::MiscMisc8x13O
+  {
+#include "fonts/8x13O/font.inc"
+  }
+  namespace Fonts::Terminus
+  {
+#include "fonts/Terminus/font.inc"
+  }
+  namespace Fonts::TerminusBold
+  {
+#include "fonts/TerminusBold/font.inc"
+  }
+}
+
+int main(void)
+{
+  using namespace LRTerminal;
+  BuiltinFonts builtinFonts;
+  Fonts::Default::load(builtinFonts);
+  Fonts::TamsynR::load(builtinFonts);
+  Fonts::TamsynB::load(builtinFonts);
+  Fonts::SonyMisc8x16::load(builtinFonts);
+  Fonts::MiscMisc8x13::load(builtinFonts);
+  Fonts::MiscMisc8x13B::load(builtinFonts);
+  Fonts::MiscMisc8x13O::load(builtinFonts);
+  Fonts::Terminus::load(builtinFonts);
+  Fonts::TerminusBold::load(builtinFonts);
+  builtinFonts.write(stdout);
+  return 0;
+}